@@ -0,0 +1,536 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Benchmarks for the vector, list and ring buffer operations and the alg.h
+ * macros, with a plain array as the baseline, for element sizes of 4 to 256
+ * bytes and container sizes from L1-resident to well beyond the last-level
+ * cache.
+ *
+ * Usage: bench [-q] [-c container] [-e elem_size] [-s bytes]...
+ *
+ *   -q  quick run: fewer repetitions and no sizes above 256 KiB
+ *   -c  only run the given container (array, vector, list, ringbuf)
+ *   -e  only run the given element size
+ *   -s  container size in bytes of payload; may be given several times
+ *
+ * Operations that shift elements (inserting and removing at the front or
+ * in the middle) are timed on a container of n elements for a bounded
+ * number of operations, so that the quadratic cost of a vector does not
+ * dominate the run time; all other operations are timed over all n
+ * elements.  gcl_copy_front is not run on vectors for the same reason.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gcl/alg.h"
+#include "gcl/list.h"
+#include "gcl/ringbuf.h"
+#include "gcl/vector.h"
+
+#include "bench.h"
+#include "elem.h"
+
+#define BENCH_BATCH                     64
+#define BENCH_MAX_SIZES                 16
+
+struct bench_config {
+    FILE *out;
+    uint64_t min_ops;
+    uint64_t move_bytes;
+    const char *container;
+    size_t elem_size;
+    size_t sizes[BENCH_MAX_SIZES];
+    size_t num_sizes;
+};
+
+/* Number of passes over n elements so that at least min_ops are timed. */
+static size_t bench_reps(const struct bench_config *cfg, size_t n)
+{
+    return n < cfg->min_ops ? cfg->min_ops / n : 1;
+}
+
+/* Number of shifting operations to time on a container of n elements. */
+static size_t bench_moves(const struct bench_config *cfg, size_t n, size_t elem_size)
+{
+    size_t moves = cfg->move_bytes / (n * elem_size);
+
+    if (moves < 16)
+        moves = 16;
+    if (moves > 1024)
+        moves = 1024;
+    return moves < n / 2 ? moves : n / 2;
+}
+
+static size_t bench_move_reps(const struct bench_config *cfg, size_t n, size_t moves)
+{
+    size_t reps = cfg->min_ops / 16 / (n + moves);
+    return reps ? reps : 1;
+}
+
+static bool bench_selected(const struct bench_config *cfg, const char *container,
+                           size_t elem_size)
+{
+    return (!cfg->container || strcmp(cfg->container, container) == 0)
+           && (!cfg->elem_size || cfg->elem_size == elem_size);
+}
+
+#define bench_init_vector(_C, cont)     init_##_C(cont, 0, NULL)
+#define bench_init_ringbuf(_C, cont)    init_##_C(cont, 0, NULL)
+#define bench_init_list(_C, cont)       init_##_C(cont, NULL)
+
+/* Whether inserting at the front takes constant time. */
+#define bench_fast_front_vector         false
+#define bench_fast_front_ringbuf        true
+#define bench_fast_front_list           true
+
+/*
+ * Generates bench_##_C, which runs all benchmarks on the container _C of
+ * kind _kind (vector, list or ringbuf) with elements of type _E##_t.
+ */
+#define BENCH_GENERATE_CONTAINER(_C, _E, _kind) \
+\
+static void bench_fill_##_C(_C##_t *cont, size_t n) \
+{ \
+    size_t i; \
+\
+    bench_init_##_kind(_C, cont); \
+    for (i = 0; i < n; i++) \
+        _C##_insert_back(cont, _E##_make(i)); \
+} \
+\
+static _C##_pos_t bench_middle_##_C(_C##_t *cont, size_t n) \
+{ \
+    _C##_pos_t pos = _C##_begin(cont); \
+    size_t i; \
+\
+    for (i = 0; i < n / 2; i++) \
+        _C##_forward(&pos); \
+    return pos; \
+} \
+\
+static void bench_##_C(const struct bench_config *cfg, size_t n) \
+{ \
+    const size_t elem_size = sizeof(_E##_t); \
+    size_t reps = bench_reps(cfg, n); \
+    size_t moves = bench_moves(cfg, n, elem_size); \
+    size_t move_reps = bench_move_reps(cfg, n, moves); \
+    size_t move_batch = moves / 16 ? moves / 16 : 1; \
+    struct bench_result res; \
+    _C##_t cont, copy; \
+    _C##_pos_t pos; \
+    _E##_t key = _E##_make(n - 1); \
+    size_t count, r; \
+    uint64_t t; \
+\
+    if (!bench_selected(cfg, #_kind, elem_size)) \
+        return; \
+\
+    bench_begin(&res, #_kind, "insert_back", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        bench_init_##_kind(_C, &cont); \
+        bench_time(&res, n, BENCH_BATCH, _C##_insert_back(&cont, _E##_make(_i))); \
+        destroy_##_C(&cont); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "insert_front", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_fill_##_C(&cont, n); \
+        bench_time(&res, moves, move_batch, _C##_insert_front(&cont, _E##_make(_i))); \
+        destroy_##_C(&cont); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "insert_middle", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_fill_##_C(&cont, n); \
+        pos = bench_middle_##_C(&cont, n); \
+        bench_time(&res, moves, move_batch, pos = _C##_insert(&cont, pos, _E##_make(_i))); \
+        destroy_##_C(&cont); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "remove_front", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_fill_##_C(&cont, n); \
+        bench_time(&res, moves, move_batch, _C##_remove_front(&cont)); \
+        destroy_##_C(&cont); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "remove_middle", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_fill_##_C(&cont, n); \
+        pos = bench_middle_##_C(&cont, n); \
+        bench_time(&res, moves, move_batch, pos = _C##_remove(&cont, pos)); \
+        destroy_##_C(&cont); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "remove_back", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        bench_fill_##_C(&cont, n); \
+        bench_time(&res, n, BENCH_BATCH, _C##_remove_back(&cont)); \
+        destroy_##_C(&cont); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "clear", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        bench_fill_##_C(&cont, n); \
+        t = bench_now(); \
+        _C##_clear(&cont); \
+        bench_add(&res, bench_now() - t, n); \
+        destroy_##_C(&cont); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_fill_##_C(&cont, n); \
+\
+    bench_begin(&res, #_kind, "iterate", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        gcl_for_each(_C, _C##_all(&cont), _E##_consume); \
+        bench_add(&res, bench_now() - t, n); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "find_eq", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        gcl_find_eq(_C, _C##_all(&cont), _E##_eq, key, &pos); \
+        bench_add(&res, bench_now() - t, n); \
+        bench_sink += _C##_at_end(&cont, pos); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "count_eq", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        gcl_count_eq(_C, _C##_all(&cont), _E##_eq, key, &count); \
+        bench_add(&res, bench_now() - t, n); \
+        bench_sink += count; \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "copy_back", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        bench_init_##_kind(_C, &copy); \
+        t = bench_now(); \
+        gcl_copy_back(_C, _C##_all(&cont), _C, &copy); \
+        bench_add(&res, bench_now() - t, n); \
+        destroy_##_C(&copy); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "copy_front", elem_size, n); \
+    for (r = 0; r < reps && bench_fast_front_##_kind; r++) { \
+        bench_init_##_kind(_C, &copy); \
+        t = bench_now(); \
+        gcl_copy_front(_C, _C##_all(&cont), _C, &copy); \
+        bench_add(&res, bench_now() - t, n); \
+        destroy_##_C(&copy); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    destroy_##_C(&cont); \
+}
+
+/*
+ * gcl_find and gcl_count compare with ==, so they are only run on
+ * containers of scalar elements.
+ */
+#define BENCH_GENERATE_SCALAR_ALG(_C, _E, _kind) \
+\
+static void bench_scalar_##_C(const struct bench_config *cfg, size_t n) \
+{ \
+    const size_t elem_size = sizeof(_E##_t); \
+    size_t reps = bench_reps(cfg, n); \
+    struct bench_result res; \
+    _C##_t cont; \
+    _C##_pos_t pos; \
+    _E##_t key = _E##_make(n - 1); \
+    size_t count, r; \
+    uint64_t t; \
+\
+    if (!bench_selected(cfg, #_kind, elem_size)) \
+        return; \
+\
+    bench_fill_##_C(&cont, n); \
+\
+    bench_begin(&res, #_kind, "find", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        gcl_find(_C, _C##_all(&cont), key, &pos); \
+        bench_add(&res, bench_now() - t, n); \
+        bench_sink += _C##_at_end(&cont, pos); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, #_kind, "count", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        gcl_count(_C, _C##_all(&cont), key, &count); \
+        bench_add(&res, bench_now() - t, n); \
+        bench_sink += count; \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    destroy_##_C(&cont); \
+}
+
+/* The baseline: a plain array with enough preallocated space. */
+#define BENCH_GENERATE_ARRAY(_E) \
+\
+static void bench_array_fill_##_E(_E##_t *a, size_t n) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        a[i] = _E##_make(i); \
+} \
+\
+static void bench_array_##_E(const struct bench_config *cfg, size_t n) \
+{ \
+    const size_t elem_size = sizeof(_E##_t); \
+    size_t reps = bench_reps(cfg, n); \
+    size_t moves = bench_moves(cfg, n, elem_size); \
+    size_t move_reps = bench_move_reps(cfg, n, moves); \
+    size_t move_batch = moves / 16 ? moves / 16 : 1; \
+    size_t mid = n / 2, len, count, r, i; \
+    struct bench_result res; \
+    _E##_t key = _E##_make(n - 1); \
+    _E##_t *a, *copy; \
+    uint64_t t; \
+\
+    if (!bench_selected(cfg, "array", elem_size)) \
+        return; \
+\
+    a = malloc((n + moves) * elem_size); \
+    copy = malloc(n * elem_size); \
+    if (!a || !copy) { \
+        perror("bench_array"); \
+        exit(EXIT_FAILURE); \
+    } \
+\
+    bench_begin(&res, "array", "insert_back", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        len = 0; \
+        bench_time(&res, n, BENCH_BATCH, a[len++] = _E##_make(_i)); \
+        bench_sink += len; \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, "array", "insert_front", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_array_fill_##_E(a, len = n); \
+        bench_time(&res, moves, move_batch, \
+                   memmove(a + 1, a, len++ * elem_size); a[0] = _E##_make(_i)); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, "array", "insert_middle", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_array_fill_##_E(a, len = n); \
+        bench_time(&res, moves, move_batch, \
+                   memmove(a + mid + 1, a + mid, (len++ - mid) * elem_size); \
+                   a[mid] = _E##_make(_i)); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, "array", "remove_front", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_array_fill_##_E(a, len = n); \
+        bench_time(&res, moves, move_batch, memmove(a, a + 1, --len * elem_size)); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, "array", "remove_middle", elem_size, n); \
+    for (r = 0; r < move_reps; r++) { \
+        bench_array_fill_##_E(a, len = n); \
+        bench_time(&res, moves, move_batch, \
+                   memmove(a + mid, a + mid + 1, (--len - mid) * elem_size)); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_array_fill_##_E(a, n); \
+\
+    bench_begin(&res, "array", "iterate", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        for (i = 0; i < n; i++) \
+            _E##_consume(a[i]); \
+        bench_add(&res, bench_now() - t, n); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, "array", "find_eq", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        for (i = 0; i < n; i++) { \
+            if (_E##_eq(a[i], key)) \
+                break; \
+        } \
+        bench_add(&res, bench_now() - t, n); \
+        bench_sink += i; \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, "array", "count_eq", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        for (i = 0, count = 0; i < n; i++) { \
+            if (_E##_eq(a[i], key)) \
+                count++; \
+        } \
+        bench_add(&res, bench_now() - t, n); \
+        bench_sink += count; \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    bench_begin(&res, "array", "copy_back", elem_size, n); \
+    for (r = 0; r < reps; r++) { \
+        t = bench_now(); \
+        memcpy(copy, a, n * elem_size); \
+        bench_add(&res, bench_now() - t, n); \
+        bench_sink += _E##_key(copy[n - 1]); \
+    } \
+    bench_end(&res, cfg->out); \
+\
+    free(copy); \
+    free(a); \
+}
+
+GCL_GENERATE_VECTOR_TYPES(vec4, elem4_t)
+GCL_GENERATE_VECTOR_TYPES(vec16, elem16_t)
+GCL_GENERATE_VECTOR_TYPES(vec64, elem64_t)
+GCL_GENERATE_VECTOR_TYPES(vec256, elem256_t)
+GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(vec4, elem4_t)
+GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(vec16, elem16_t)
+GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(vec64, elem64_t)
+GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(vec256, elem256_t)
+
+GCL_GENERATE_LIST_TYPES(list4, elem4_t)
+GCL_GENERATE_LIST_TYPES(list16, elem16_t)
+GCL_GENERATE_LIST_TYPES(list64, elem64_t)
+GCL_GENERATE_LIST_TYPES(list256, elem256_t)
+GCL_GENERATE_LIST_FUNCTIONS_STATIC(list4, elem4_t)
+GCL_GENERATE_LIST_FUNCTIONS_STATIC(list16, elem16_t)
+GCL_GENERATE_LIST_FUNCTIONS_STATIC(list64, elem64_t)
+GCL_GENERATE_LIST_FUNCTIONS_STATIC(list256, elem256_t)
+
+GCL_GENERATE_RINGBUF_TYPES(ring4, elem4_t)
+GCL_GENERATE_RINGBUF_TYPES(ring16, elem16_t)
+GCL_GENERATE_RINGBUF_TYPES(ring64, elem64_t)
+GCL_GENERATE_RINGBUF_TYPES(ring256, elem256_t)
+GCL_GENERATE_RINGBUF_FUNCTIONS_STATIC(ring4, elem4_t)
+GCL_GENERATE_RINGBUF_FUNCTIONS_STATIC(ring16, elem16_t)
+GCL_GENERATE_RINGBUF_FUNCTIONS_STATIC(ring64, elem64_t)
+GCL_GENERATE_RINGBUF_FUNCTIONS_STATIC(ring256, elem256_t)
+
+BENCH_GENERATE_ARRAY(elem4)
+BENCH_GENERATE_ARRAY(elem16)
+BENCH_GENERATE_ARRAY(elem64)
+BENCH_GENERATE_ARRAY(elem256)
+
+BENCH_GENERATE_CONTAINER(vec4, elem4, vector)
+BENCH_GENERATE_CONTAINER(vec16, elem16, vector)
+BENCH_GENERATE_CONTAINER(vec64, elem64, vector)
+BENCH_GENERATE_CONTAINER(vec256, elem256, vector)
+
+BENCH_GENERATE_CONTAINER(list4, elem4, list)
+BENCH_GENERATE_CONTAINER(list16, elem16, list)
+BENCH_GENERATE_CONTAINER(list64, elem64, list)
+BENCH_GENERATE_CONTAINER(list256, elem256, list)
+
+BENCH_GENERATE_CONTAINER(ring4, elem4, ringbuf)
+BENCH_GENERATE_CONTAINER(ring16, elem16, ringbuf)
+BENCH_GENERATE_CONTAINER(ring64, elem64, ringbuf)
+BENCH_GENERATE_CONTAINER(ring256, elem256, ringbuf)
+
+BENCH_GENERATE_SCALAR_ALG(vec4, elem4, vector)
+BENCH_GENERATE_SCALAR_ALG(list4, elem4, list)
+BENCH_GENERATE_SCALAR_ALG(ring4, elem4, ringbuf)
+
+#define bench_run_elem(cfg, bytes, size) \
+    do { \
+        size_t _n = (bytes) / (size); \
+        if (_n >= 2) { \
+            bench_array_elem##size(cfg, _n); \
+            bench_vec##size(cfg, _n); \
+            bench_list##size(cfg, _n); \
+            bench_ring##size(cfg, _n); \
+        } \
+    } while (0)
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-q] [-c container] [-e elem_size] [-s bytes]...\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_config cfg = {
+        .out = stdout,
+        .min_ops = 1 << 20,
+        .move_bytes = 1 << 30,
+    };
+    static const size_t default_sizes[] = { 16 << 10, 256 << 10, 4 << 20, 64 << 20 };
+    size_t num_default_sizes = sizeof(default_sizes) / sizeof(default_sizes[0]);
+    size_t i, n;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "qc:e:s:")) != -1) {
+        switch (opt) {
+        case 'q':
+            cfg.min_ops = 1 << 16;
+            cfg.move_bytes = 1 << 24;
+            num_default_sizes = 2;
+            break;
+        case 'c':
+            cfg.container = optarg;
+            break;
+        case 'e':
+            cfg.elem_size = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            if (cfg.num_sizes == BENCH_MAX_SIZES)
+                usage(argv[0]);
+            cfg.sizes[cfg.num_sizes++] = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (!cfg.num_sizes) {
+        for (i = 0; i < num_default_sizes; i++)
+            cfg.sizes[cfg.num_sizes++] = default_sizes[i];
+    }
+
+    for (i = 0; i < cfg.num_sizes; i++) {
+        bench_run_elem(&cfg, cfg.sizes[i], 4);
+        bench_run_elem(&cfg, cfg.sizes[i], 16);
+        bench_run_elem(&cfg, cfg.sizes[i], 64);
+        bench_run_elem(&cfg, cfg.sizes[i], 256);
+
+        n = cfg.sizes[i] / sizeof(elem4_t);
+        if (n >= 2) {
+            bench_scalar_vec4(&cfg, n);
+            bench_scalar_list4(&cfg, n);
+            bench_scalar_ring4(&cfg, n);
+        }
+    }
+
+    /* Keeps the consumed values observable. */
+    fprintf(stderr, "sink: %llu\n", (unsigned long long) bench_sink);
+    return 0;
+}
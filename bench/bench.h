@@ -0,0 +1,71 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Timing and reporting for the benchmarks.
+ *
+ * A measurement times batches of operations and records the time per
+ * operation of every batch as one sample; the report gives the mean over
+ * all operations and percentiles over the samples.  Results are written as
+ * one JSON object per line.
+ */
+
+#ifndef GCL_BENCH_H
+#define GCL_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct bench_result {
+    const char *container;
+    const char *op;
+    size_t elem_size;
+    size_t n;
+    uint64_t ops;
+    uint64_t total_ns;
+    double *samples;
+    size_t num_samples;
+    size_t max_samples;
+};
+
+/* Consumed by the benchmarked loops so that they are not optimized away. */
+extern uint64_t bench_sink;
+
+static inline uint64_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+void bench_begin(struct bench_result *res, const char *container, const char *op,
+                 size_t elem_size, size_t n);
+void bench_add(struct bench_result *res, uint64_t ns, uint64_t ops);
+void bench_end(struct bench_result *res, FILE *out);
+
+/*
+ * Runs stmt num_ops times in batches of batch operations and adds one
+ * sample per batch.  stmt may use the loop counter _i.
+ */
+#define bench_time(res, num_ops, batch, stmt) \
+    do { \
+        size_t _i = 0, _j, _n; \
+        uint64_t _t; \
+        while (_i < (num_ops)) { \
+            _n = (num_ops) - _i < (batch) ? (num_ops) - _i : (batch); \
+            _t = bench_now(); \
+            for (_j = 0; _j < _n; _j++, _i++) { \
+                stmt; \
+            } \
+            bench_add(res, bench_now() - _t, _n); \
+        } \
+    } while (0)
+
+#endif
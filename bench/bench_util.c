@@ -0,0 +1,80 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+#include <string.h>
+
+#include "bench.h"
+
+uint64_t bench_sink;
+
+void bench_begin(struct bench_result *res, const char *container, const char *op,
+                 size_t elem_size, size_t n)
+{
+    memset(res, 0, sizeof(*res));
+    res->container = container;
+    res->op = op;
+    res->elem_size = elem_size;
+    res->n = n;
+}
+
+void bench_add(struct bench_result *res, uint64_t ns, uint64_t ops)
+{
+    double *samples;
+    size_t max_samples;
+
+    res->total_ns += ns;
+    res->ops += ops;
+
+    if (res->num_samples == res->max_samples) {
+        max_samples = res->max_samples ? 2 * res->max_samples : 64;
+        if (!(samples = realloc(res->samples, max_samples * sizeof(double)))) {
+            perror("bench_add");
+            exit(EXIT_FAILURE);
+        }
+        res->samples = samples;
+        res->max_samples = max_samples;
+    }
+
+    res->samples[res->num_samples++] = (double) ns / (double) ops;
+}
+
+static int compare_samples(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+/* Nearest-rank percentile of the sorted samples. */
+static double percentile(const struct bench_result *res, unsigned p)
+{
+    size_t rank = (res->num_samples * p + 99) / 100;
+    return res->samples[rank ? rank - 1 : 0];
+}
+
+void bench_end(struct bench_result *res, FILE *out)
+{
+    double ns_per_op;
+
+    if (!res->num_samples)
+        return;
+
+    qsort(res->samples, res->num_samples, sizeof(double), compare_samples);
+    ns_per_op = (double) res->total_ns / (double) res->ops;
+
+    fprintf(out, "{\"container\": \"%s\", \"op\": \"%s\", \"elem_size\": %zu, \"n\": %zu, "
+            "\"ops\": %llu, \"samples\": %zu, \"ns_per_op\": %.3f, \"ops_per_s\": %.0f, "
+            "\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}\n",
+            res->container, res->op, res->elem_size, res->n,
+            (unsigned long long) res->ops, res->num_samples, ns_per_op,
+            ns_per_op > 0 ? 1e9 / ns_per_op : 0.0,
+            res->samples[0], percentile(res, 50), percentile(res, 90),
+            percentile(res, 99), res->samples[res->num_samples - 1]);
+    fflush(out);
+
+    free(res->samples);
+    res->samples = NULL;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+#ifndef GCL_BENCH_ELEM_H
+#define GCL_BENCH_ELEM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bench.h"
+
+/*
+ * Element types.  Every element has a 32-bit key; the larger ones are
+ * padded to their size.
+ */
+
+typedef uint32_t elem4_t;
+
+static inline elem4_t elem4_make(size_t i) { return (elem4_t) i; }
+static inline uint32_t elem4_key(elem4_t x) { return x; }
+
+#define BENCH_GENERATE_ELEM_TYPE(_E, size) \
+\
+typedef struct { \
+    uint32_t key; \
+    char pad[(size) - sizeof(uint32_t)]; \
+} _E##_t; \
+\
+static inline _E##_t _E##_make(size_t i) \
+{ \
+    _E##_t x; \
+    memset(&x, 0, sizeof(x)); \
+    x.key = (uint32_t) i; \
+    return x; \
+} \
+\
+static inline uint32_t _E##_key(_E##_t x) { return x.key; }
+
+#define BENCH_GENERATE_ELEM_FUNCTIONS(_E) \
+\
+static inline bool _E##_eq(_E##_t a, _E##_t b) { return _E##_key(a) == _E##_key(b); } \
+static inline void _E##_consume(_E##_t x) { bench_sink += _E##_key(x); }
+
+BENCH_GENERATE_ELEM_TYPE(elem16, 16)
+BENCH_GENERATE_ELEM_TYPE(elem64, 64)
+BENCH_GENERATE_ELEM_TYPE(elem256, 256)
+
+BENCH_GENERATE_ELEM_FUNCTIONS(elem4)
+BENCH_GENERATE_ELEM_FUNCTIONS(elem16)
+BENCH_GENERATE_ELEM_FUNCTIONS(elem64)
+BENCH_GENERATE_ELEM_FUNCTIONS(elem256)
+
+#endif
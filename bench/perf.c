@@ -0,0 +1,189 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/* For syscall. */
+#define _GNU_SOURCE
+
+#include <string.h>
+
+#include "bench.h"
+#include "perf.h"
+
+static const char *const counter_names[BENCH_PERF_NUM_COUNTERS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define _bench_perf_cache(cache, op, result) \
+    ((cache) | ((op) << 8) | ((result) << 16))
+
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} counter_events[BENCH_PERF_NUM_COUNTERS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, _bench_perf_cache(PERF_COUNT_HW_CACHE_L1D,
+                                            PERF_COUNT_HW_CACHE_OP_READ,
+                                            PERF_COUNT_HW_CACHE_RESULT_MISS) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+static int open_counter(int i)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = counter_events[i].type;
+    attr.config = counter_events[i].config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+int bench_perf_open(struct bench_perf *perf)
+{
+    int i, num_open = 0;
+
+    memset(perf, 0, sizeof(*perf));
+
+    for (i = 0; i < BENCH_PERF_NUM_COUNTERS; i++) {
+        if ((perf->fd[i] = open_counter(i)) >= 0)
+            num_open++;
+    }
+
+    return num_open;
+}
+
+void bench_perf_close(struct bench_perf *perf)
+{
+    int i;
+
+    for (i = 0; i < BENCH_PERF_NUM_COUNTERS; i++) {
+        if (perf->fd[i] >= 0)
+            close(perf->fd[i]);
+        perf->fd[i] = -1;
+    }
+}
+
+void bench_perf_start(struct bench_perf *perf)
+{
+    uint64_t buf[3];
+    int i;
+
+    /*
+     * PERF_EVENT_IOC_RESET clears the value but not the enabled and running
+     * times, so remember those to scale by the times of this interval.
+     */
+    for (i = 0; i < BENCH_PERF_NUM_COUNTERS; i++) {
+        if (perf->fd[i] >= 0) {
+            ioctl(perf->fd[i], PERF_EVENT_IOC_RESET, 0);
+            if (read(perf->fd[i], buf, sizeof(buf)) == sizeof(buf)) {
+                perf->start_enabled[i] = buf[1];
+                perf->start_running[i] = buf[2];
+            }
+            ioctl(perf->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    perf->start_ns = bench_now();
+}
+
+void bench_perf_stop(struct bench_perf *perf, uint64_t ops)
+{
+    uint64_t end_ns = bench_now();
+    uint64_t buf[3], enabled, running;
+    int i;
+
+    for (i = 0; i < BENCH_PERF_NUM_COUNTERS; i++) {
+        if (perf->fd[i] >= 0)
+            ioctl(perf->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    perf->ns += end_ns - perf->start_ns;
+    perf->ops += ops;
+
+    /* buf holds the value, the time enabled and the time running. */
+    for (i = 0; i < BENCH_PERF_NUM_COUNTERS; i++) {
+        if (perf->fd[i] < 0 || read(perf->fd[i], buf, sizeof(buf)) != sizeof(buf))
+            continue;
+        enabled = buf[1] - perf->start_enabled[i];
+        running = buf[2] - perf->start_running[i];
+        if (running)
+            perf->values[i] += (double) buf[0] * ((double) enabled / (double) running);
+    }
+}
+
+#else
+
+int bench_perf_open(struct bench_perf *perf)
+{
+    int i;
+
+    memset(perf, 0, sizeof(*perf));
+    for (i = 0; i < BENCH_PERF_NUM_COUNTERS; i++)
+        perf->fd[i] = -1;
+    return 0;
+}
+
+void bench_perf_close(struct bench_perf *perf)
+{
+    (void) perf;
+}
+
+void bench_perf_start(struct bench_perf *perf)
+{
+    perf->start_ns = bench_now();
+}
+
+void bench_perf_stop(struct bench_perf *perf, uint64_t ops)
+{
+    perf->ns += bench_now() - perf->start_ns;
+    perf->ops += ops;
+}
+
+#endif
+
+void bench_perf_reset(struct bench_perf *perf)
+{
+    memset(perf->values, 0, sizeof(perf->values));
+    perf->ns = 0;
+    perf->ops = 0;
+}
+
+void bench_perf_report(const struct bench_perf *perf, FILE *out, const char *container,
+                       const char *op, size_t elem_size, size_t n)
+{
+    double ops = perf->ops ? (double) perf->ops : 1.0;
+    int i;
+
+    fprintf(out, "{\"container\": \"%s\", \"op\": \"%s\", \"elem_size\": %zu, \"n\": %zu, "
+            "\"ops\": %llu, \"ns_per_op\": %.3f",
+            container, op, elem_size, n, (unsigned long long) perf->ops,
+            (double) perf->ns / ops);
+
+    for (i = 0; i < BENCH_PERF_NUM_COUNTERS; i++) {
+        if (perf->fd[i] >= 0)
+            fprintf(out, ", \"%s_per_op\": %.4f", counter_names[i], perf->values[i] / ops);
+        else
+            fprintf(out, ", \"%s_per_op\": null", counter_names[i]);
+    }
+
+    fputs("}\n", out);
+    fflush(out);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Hardware performance counters for the benchmarks.
+ *
+ * On Linux, bench_perf_open opens counters for cycles, instructions, L1
+ * data cache read misses, last-level cache misses and branch misses with
+ * perf_event_open, counting user space only.  Counters that cannot be
+ * opened (no PMU, a virtual machine, perf_event_paranoid too high) are
+ * left out, and without any counter only the time measured with
+ * clock_gettime is reported.  Values are scaled by the time a counter was
+ * actually scheduled if the kernel had to multiplex the counters.
+ */
+
+#ifndef GCL_BENCH_PERF_H
+#define GCL_BENCH_PERF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+enum bench_perf_counter {
+    BENCH_PERF_CYCLES,
+    BENCH_PERF_INSTRUCTIONS,
+    BENCH_PERF_L1D_MISSES,
+    BENCH_PERF_LLC_MISSES,
+    BENCH_PERF_BRANCH_MISSES,
+    BENCH_PERF_NUM_COUNTERS
+};
+
+struct bench_perf {
+    int fd[BENCH_PERF_NUM_COUNTERS];
+    double values[BENCH_PERF_NUM_COUNTERS];
+    uint64_t start_enabled[BENCH_PERF_NUM_COUNTERS];
+    uint64_t start_running[BENCH_PERF_NUM_COUNTERS];
+    uint64_t start_ns;
+    uint64_t ns;
+    uint64_t ops;
+};
+
+/* Returns the number of counters that could be opened. */
+int bench_perf_open(struct bench_perf *perf);
+void bench_perf_close(struct bench_perf *perf);
+
+/* Clears the accumulated values. */
+void bench_perf_reset(struct bench_perf *perf);
+
+/* Counts the operations between start and stop; measurements accumulate. */
+void bench_perf_start(struct bench_perf *perf);
+void bench_perf_stop(struct bench_perf *perf, uint64_t ops);
+
+/* Writes the values per operation as one JSON object. */
+void bench_perf_report(const struct bench_perf *perf, FILE *out, const char *container,
+                       const char *op, size_t elem_size, size_t n);
+
+#endif
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Microbenchmarks that report hardware counters per operation, for judging
+ * layout changes by their cache behaviour rather than by wall-clock time
+ * alone:
+ *
+ *   ringbuf  iterate with gcl_for_each and with _gcl_ringbuf_for_each_ptr
+ *            over a buffer whose contents wrap around
+ *   list     iterate over nodes allocated in traversal order, over the same
+ *            nodes relinked in random order, and after _C##_compact
+ *   vector   insert and remove in the middle, which shift half the
+ *            elements with _##_C##_move_data
+ *
+ * Usage: perf_bench [-q] [-e elem_size] [-s bytes]...
+ *
+ * If no hardware counter can be opened, the counter fields are null and
+ * only ns_per_op is measured.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gcl/alg.h"
+#include "gcl/list.h"
+#include "gcl/ringbuf.h"
+#include "gcl/vector.h"
+
+#include "bench.h"
+#include "elem.h"
+#include "perf.h"
+
+#define PERF_BENCH_REPS                 3
+#define PERF_BENCH_MAX_SIZES            16
+
+struct perf_bench_config {
+    FILE *out;
+    size_t elem_size;
+    uint64_t min_ops;
+    size_t sizes[PERF_BENCH_MAX_SIZES];
+    size_t num_sizes;
+};
+
+static struct bench_perf perf;
+
+static size_t perf_bench_reps(const struct perf_bench_config *cfg, size_t n)
+{
+    size_t reps = cfg->min_ops / n;
+    return reps < PERF_BENCH_REPS ? PERF_BENCH_REPS : reps;
+}
+
+/* Bounds the bytes shifted by the vector benchmarks, as in bench.c. */
+static size_t perf_bench_moves(size_t bytes)
+{
+    size_t moves = (1 << 30) / bytes;
+
+    if (moves < 16)
+        moves = 16;
+    return moves < 1024 ? moves : 1024;
+}
+
+/* A small xorshift generator, so that runs are reproducible. */
+static uint64_t perf_bench_random(void)
+{
+    static uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+#define PERF_BENCH_GENERATE(_E) \
+\
+GCL_GENERATE_RINGBUF_TYPES(_E##_ring, _E##_t) \
+GCL_GENERATE_RINGBUF_FUNCTIONS_STATIC(_E##_ring, _E##_t) \
+GCL_GENERATE_LIST_TYPES(_E##_list, _E##_t) \
+GCL_GENERATE_LIST_FUNCTIONS_STATIC(_E##_list, _E##_t) \
+GCL_GENERATE_VECTOR_TYPES(_E##_vec, _E##_t) \
+GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_E##_vec, _E##_t) \
+\
+static void perf_bench_ringbuf_##_E(const struct perf_bench_config *cfg, size_t n) \
+{ \
+    size_t reps = perf_bench_reps(cfg, n), r, i; \
+    _E##_ring_t buf; \
+    _E##_t *ptr; \
+\
+    init_##_E##_ring(&buf, n, NULL); \
+    for (i = 0; i < n; i++) \
+        _E##_ring_insert_back(&buf, _E##_make(i)); \
+    for (i = 0; i < n / 2; i++) { \
+        _E##_ring_remove_front(&buf); \
+        _E##_ring_insert_back(&buf, _E##_make(i)); \
+    } \
+\
+    bench_perf_reset(&perf); \
+    for (r = 0; r < reps; r++) { \
+        bench_perf_start(&perf); \
+        gcl_for_each(_E##_ring, _E##_ring_all(&buf), _E##_consume); \
+        bench_perf_stop(&perf, n); \
+    } \
+    bench_perf_report(&perf, cfg->out, "ringbuf", "iterate", sizeof(_E##_t), n); \
+\
+    bench_perf_reset(&perf); \
+    for (r = 0; r < reps; r++) { \
+        bench_perf_start(&perf); \
+        _gcl_ringbuf_for_each_ptr(ptr, &buf) \
+            _E##_consume(*ptr); \
+        bench_perf_stop(&perf, n); \
+    } \
+    bench_perf_report(&perf, cfg->out, "ringbuf", "iterate_ptr", sizeof(_E##_t), n); \
+\
+    destroy_##_E##_ring(&buf); \
+} \
+\
+static void perf_bench_list_iterate_##_E(const struct perf_bench_config *cfg, \
+                                         _E##_list_t *list, size_t n, const char *op) \
+{ \
+    size_t reps = perf_bench_reps(cfg, n), r; \
+\
+    bench_perf_reset(&perf); \
+    for (r = 0; r < reps; r++) { \
+        bench_perf_start(&perf); \
+        gcl_for_each(_E##_list, _E##_list_all(list), _E##_consume); \
+        bench_perf_stop(&perf, n); \
+    } \
+    bench_perf_report(&perf, cfg->out, "list", op, sizeof(_E##_t), n); \
+} \
+\
+static void perf_bench_list_##_E(const struct perf_bench_config *cfg, size_t n) \
+{ \
+    _E##_list_node_t **nodes, *tmp; \
+    _E##_list_t list; \
+    size_t i, j; \
+\
+    if (!(nodes = malloc(n * sizeof(*nodes)))) { \
+        perror("perf_bench_list"); \
+        exit(EXIT_FAILURE); \
+    } \
+\
+    init_##_E##_list(&list, NULL); \
+    for (i = 0; i < n; i++) \
+        nodes[i] = _E##_list_insert_back(&list, _E##_make(i)); \
+\
+    perf_bench_list_iterate_##_E(cfg, &list, n, "iterate_seq"); \
+\
+    for (i = n - 1; i > 0; i--) { \
+        j = (size_t) (perf_bench_random() % (i + 1)); \
+        tmp = nodes[i]; \
+        nodes[i] = nodes[j]; \
+        nodes[j] = tmp; \
+    } \
+    _E##_list_link_nodes(_E##_list_end(&list), nodes[0]); \
+    for (i = 1; i < n; i++) \
+        _E##_list_link_nodes(nodes[i - 1], nodes[i]); \
+    _E##_list_link_nodes(nodes[n - 1], _E##_list_end(&list)); \
+\
+    perf_bench_list_iterate_##_E(cfg, &list, n, "iterate_shuffled"); \
+\
+    _E##_list_compact(&list); \
+    perf_bench_list_iterate_##_E(cfg, &list, n, "iterate_compact"); \
+\
+    destroy_##_E##_list(&list); \
+    free(nodes); \
+} \
+\
+static void perf_bench_vector_##_E(const struct perf_bench_config *cfg, size_t n) \
+{ \
+    size_t ops = perf_bench_moves(n * sizeof(_E##_t)), r, i; \
+    _E##_vec_t vec; \
+    _E##_vec_pos_t pos; \
+\
+    if (ops > n / 2) \
+        ops = n / 2; \
+\
+    bench_perf_reset(&perf); \
+    for (r = 0; r < PERF_BENCH_REPS; r++) { \
+        init_##_E##_vec(&vec, n + ops, NULL); \
+        for (i = 0; i < n; i++) \
+            _E##_vec_insert_back(&vec, _E##_make(i)); \
+        pos = vec.data + n / 2; \
+        bench_perf_start(&perf); \
+        for (i = 0; i < ops; i++) \
+            pos = _E##_vec_insert(&vec, pos, _E##_make(i)); \
+        bench_perf_stop(&perf, ops); \
+        destroy_##_E##_vec(&vec); \
+    } \
+    bench_perf_report(&perf, cfg->out, "vector", "insert_middle", sizeof(_E##_t), n); \
+\
+    bench_perf_reset(&perf); \
+    for (r = 0; r < PERF_BENCH_REPS; r++) { \
+        init_##_E##_vec(&vec, n, NULL); \
+        for (i = 0; i < n; i++) \
+            _E##_vec_insert_back(&vec, _E##_make(i)); \
+        pos = vec.data + n / 2; \
+        bench_perf_start(&perf); \
+        for (i = 0; i < ops; i++) \
+            pos = _E##_vec_remove(&vec, pos); \
+        bench_perf_stop(&perf, ops); \
+        destroy_##_E##_vec(&vec); \
+    } \
+    bench_perf_report(&perf, cfg->out, "vector", "remove_middle", sizeof(_E##_t), n); \
+} \
+\
+static void perf_bench_##_E(const struct perf_bench_config *cfg, size_t bytes) \
+{ \
+    size_t n = bytes / sizeof(_E##_t); \
+\
+    if (n < 2 || (cfg->elem_size && cfg->elem_size != sizeof(_E##_t))) \
+        return; \
+\
+    perf_bench_ringbuf_##_E(cfg, n); \
+    perf_bench_list_##_E(cfg, n); \
+    perf_bench_vector_##_E(cfg, n); \
+}
+
+PERF_BENCH_GENERATE(elem4)
+PERF_BENCH_GENERATE(elem16)
+PERF_BENCH_GENERATE(elem64)
+PERF_BENCH_GENERATE(elem256)
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-q] [-e elem_size] [-s bytes]...\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv)
+{
+    struct perf_bench_config cfg = {
+        .out = stdout,
+        .min_ops = 1 << 22,
+    };
+    static const size_t default_sizes[] = { 16 << 10, 256 << 10, 4 << 20, 64 << 20 };
+    size_t num_default_sizes = sizeof(default_sizes) / sizeof(default_sizes[0]);
+    size_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "qe:s:")) != -1) {
+        switch (opt) {
+        case 'q':
+            cfg.min_ops = 1 << 16;
+            num_default_sizes = 2;
+            break;
+        case 'e':
+            cfg.elem_size = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            if (cfg.num_sizes == PERF_BENCH_MAX_SIZES)
+                usage(argv[0]);
+            cfg.sizes[cfg.num_sizes++] = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (!cfg.num_sizes) {
+        for (i = 0; i < num_default_sizes; i++)
+            cfg.sizes[cfg.num_sizes++] = default_sizes[i];
+    }
+
+    if (!bench_perf_open(&perf))
+        fprintf(stderr, "perf_bench: no hardware counters available, measuring time only\n");
+
+    for (i = 0; i < cfg.num_sizes; i++) {
+        perf_bench_elem4(&cfg, cfg.sizes[i]);
+        perf_bench_elem16(&cfg, cfg.sizes[i]);
+        perf_bench_elem64(&cfg, cfg.sizes[i]);
+        perf_bench_elem256(&cfg, cfg.sizes[i]);
+    }
+
+    bench_perf_close(&perf);
+    fprintf(stderr, "sink: %llu\n", (unsigned long long) bench_sink);
+    return 0;
+}
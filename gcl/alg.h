@@ -8,6 +8,18 @@
 #ifndef GCL_ALG_H
 #define GCL_ALG_H
 
+#include "traits.h"
+
+#ifndef GCL_PREFETCH_DISTANCE
+#define GCL_PREFETCH_DISTANCE           (4)
+#endif
+
+#if defined(__GNUC__)
+#define _gcl_prefetch(ptr)              __builtin_prefetch(ptr)
+#else
+#define _gcl_prefetch(ptr)              ((void) (ptr))
+#endif
+
 #define gcl_for_each_pos(_C, pos, range) \
     for ((pos) = _C##_range_begin(range); \
          !_C##_range_at_end(range, pos); \
@@ -37,6 +49,40 @@
             (f)(_C##_get(_pos)); \
     } while (0)
 
+/*
+ * The prefetching variants keep a second position GCL_PREFETCH_DISTANCE
+ * elements ahead of the current one.  Each step advances it by one element
+ * and prefetches the element it lands on, which is not touched again until
+ * the next step and not consumed until GCL_PREFETCH_DISTANCE steps later.
+ * This hides part of the latency of walking linked containers.
+ */
+#define _gcl_prefetch_ahead(_C, range, ahead) \
+    do { \
+        if (!_C##_range_at_end(range, ahead)) { \
+            _C##_forward(&(ahead)); \
+            if (!_C##_range_at_end(range, ahead)) \
+                _gcl_prefetch(_C##_get_ptr(ahead)); \
+        } \
+    } while (0)
+
+#define _gcl_prefetch_init(_C, range, ahead) \
+    do { \
+        int _i; \
+        (ahead) = _C##_range_begin(range); \
+        for (_i = 0; _i < GCL_PREFETCH_DISTANCE; _i++) \
+            _gcl_prefetch_ahead(_C, range, ahead); \
+    } while (0)
+
+#define gcl_for_each_prefetch(_C, range, f) \
+    do { \
+        _C##_pos_t _pos, _ahead; \
+        _gcl_prefetch_init(_C, range, _ahead); \
+        gcl_for_each_pos(_C, _pos, range) { \
+            _gcl_prefetch_ahead(_C, range, _ahead); \
+            (f)(_C##_get(_pos)); \
+        } \
+    } while (0)
+
 #define gcl_find(_C, range, val, pos) \
     do { \
         gcl_for_each_pos(_C, *(pos), range) { \
@@ -53,6 +99,18 @@
         } \
     } while (0)
 
+/*
+ * The _traits variants compare with the eq macro of a traits set (see
+ * traits.h), which the compiler can inline, instead of a function.
+ */
+#define gcl_find_traits(_C, range, traits, val, pos) \
+    do { \
+        gcl_for_each_pos(_C, *(pos), range) { \
+            if (_gcl_traits_eq(traits, _C##_get(*(pos)), (val))) \
+                break; \
+        } \
+    } while (0)
+
 #define gcl_find_if(_C, range, pred, pos) \
     do { \
         gcl_for_each_pos(_C, *(pos), range) { \
@@ -61,12 +119,23 @@
         } \
     } while (0)
 
+#define gcl_find_if_prefetch(_C, range, pred, pos) \
+    do { \
+        _C##_pos_t _ahead; \
+        _gcl_prefetch_init(_C, range, _ahead); \
+        gcl_for_each_pos(_C, *(pos), range) { \
+            _gcl_prefetch_ahead(_C, range, _ahead); \
+            if ((pred)(_C##_get(*(pos)))) \
+                break; \
+        } \
+    } while (0)
+
 #define gcl_count(_C, range, val, n) \
     do { \
         _C##_pos_t _pos; \
         *(n) = 0; \
-        gcl_for_each_pos(_C, *(_pos), range) { \
-            if (_C##_get(*(_pos)) == (val)) \
+        gcl_for_each_pos(_C, _pos, range) { \
+            if (_C##_get(_pos) == (val)) \
                 (*(n))++; \
         } \
     } while (0)
@@ -75,8 +144,18 @@
     do { \
         _C##_pos_t _pos; \
         *(n) = 0; \
-        gcl_for_each_pos(_C, *(_pos), range) { \
-            if ((eq)(_C##_get(*(_pos)), (val))) \
+        gcl_for_each_pos(_C, _pos, range) { \
+            if ((eq)(_C##_get(_pos), (val))) \
+                (*(n))++; \
+        } \
+    } while (0)
+
+#define gcl_count_traits(_C, range, traits, val, n) \
+    do { \
+        _C##_pos_t _pos; \
+        *(n) = 0; \
+        gcl_for_each_pos(_C, _pos, range) { \
+            if (_gcl_traits_eq(traits, _C##_get(_pos), (val))) \
                 (*(n))++; \
         } \
     } while (0)
@@ -85,8 +164,8 @@
     do { \
         _C##_pos_t _pos; \
         *(n) = 0; \
-        gcl_for_each_pos(_C, *(_pos), range) { \
-            if ((pred)(_C##_get(*(_pos)))) \
+        gcl_for_each_pos(_C, _pos, range) { \
+            if ((pred)(_C##_get(_pos))) \
                 (*(n))++; \
         } \
     } while (0)
@@ -95,7 +174,7 @@
     do { \
         _C##_pos_t _pos; \
         *(n) = 0; \
-        gcl_for_each_pos(_C, *(_pos), range) \
+        gcl_for_each_pos(_C, _pos, range) \
             (*(n))++; \
     } while (0)
 
@@ -123,6 +202,14 @@
         } \
     } while (0)
 
+#define gcl_copy_back_traits(_C1, range, _C2, cont, traits) \
+    do { \
+        _C1##_pos_t _pos; \
+        gcl_for_each_pos(_C1, _pos, range) { \
+            _C2##_insert_back(cont, _gcl_traits_copy(traits, _C1##_get(_pos))); \
+        } \
+    } while (0)
+
 #define gcl_fill(_C, range, val) \
     do { \
         _C##_pos_t _pos; \
@@ -131,12 +218,146 @@
         } \
     } while(0)
 
+/*
+ * gcl_remove_if and gcl_unique compact the whole container in a single
+ * pass, destroying the removed elements, and then cut off the tail with
+ * _C##_release_tail.
+ */
+#define gcl_remove_if(_C, cont, pred) \
+    do { \
+        _C##_pos_t _pos, _dest = _C##_begin(cont); \
+        gcl_for_each_pos(_C, _pos, _C##_all(cont)) { \
+            if ((pred)(_C##_get(_pos))) { \
+                _##_C##_destroy_elem(cont, _C##_get(_pos)); \
+            } else { \
+                _C##_set(_dest, _C##_get(_pos)); \
+                _C##_forward(&_dest); \
+            } \
+        } \
+        _C##_release_tail(cont, _dest); \
+    } while (0)
+
+#define gcl_unique(_C, cont, eq) \
+    do { \
+        _C##_pos_t _pos, _dest = _C##_begin(cont); \
+        if (!_C##_empty(cont)) { \
+            _C##_forward(&_dest); \
+            gcl_for_each_pos(_C, _pos, _C##_range_from_pos(cont, _dest)) { \
+                if ((eq)(_C##_get(_C##_prev(_dest)), _C##_get(_pos))) { \
+                    _##_C##_destroy_elem(cont, _C##_get(_pos)); \
+                } else { \
+                    _C##_set(_dest, _C##_get(_pos)); \
+                    _C##_forward(&_dest); \
+                } \
+            } \
+        } \
+        _C##_release_tail(cont, _dest); \
+    } while (0)
+
+#define gcl_unique_traits(_C, cont, traits) \
+    do { \
+        _C##_pos_t _pos, _dest = _C##_begin(cont); \
+        if (!_C##_empty(cont)) { \
+            _C##_forward(&_dest); \
+            gcl_for_each_pos(_C, _pos, _C##_range_from_pos(cont, _dest)) { \
+                if (_gcl_traits_eq(traits, _C##_get(_C##_prev(_dest)), _C##_get(_pos))) { \
+                    _gcl_traits_destroy(traits, _C##_get(_pos)); \
+                } else { \
+                    _C##_set(_dest, _C##_get(_pos)); \
+                    _C##_forward(&_dest); \
+                } \
+            } \
+        } \
+        _C##_release_tail(cont, _dest); \
+    } while (0)
+
+/*
+ * Heaps over ranges of vectors, or of other containers that store their
+ * elements contiguously.  cmp(x, y) returns a negative value if x should be
+ * closer to the top than y, zero if they are equivalent, and a positive
+ * value otherwise, so the top of the heap is its smallest element.  cmp may
+ * be a function or a function-like macro.  gcl_push_heap restores the heap
+ * after an element has been appended to it, and gcl_pop_heap moves the top
+ * element to the end of the range and restores the heap on the rest.
+ *
+ * The _gcl_heap_sift macros work on D-ary heaps and call set_index(elem, i)
+ * whenever they store an element at index i.
+ */
+#define _gcl_heap_no_index(elem, i)     ((void) 0)
+
+#define _gcl_heap_sift_up(_T, base, i, cmp, D, set_index) \
+    do { \
+        size_t _hi = (i), _hp; \
+        _T _htmp = (base)[_hi]; \
+        while (_hi > 0) { \
+            _hp = (_hi - 1) / (D); \
+            if (cmp((base)[_hp], _htmp) <= 0) \
+                break; \
+            (base)[_hi] = (base)[_hp]; \
+            set_index((base)[_hi], _hi); \
+            _hi = _hp; \
+        } \
+        (base)[_hi] = _htmp; \
+        set_index((base)[_hi], _hi); \
+    } while (0)
+
+#define _gcl_heap_sift_down(_T, base, n, i, cmp, D, set_index) \
+    do { \
+        size_t _hi = (i), _hc, _hbest, _hend; \
+        _T _htmp = (base)[_hi]; \
+        while ((_hc = (D) * _hi + 1) < (n)) { \
+            _hend = _hc + (D) < (n) ? _hc + (D) : (n); \
+            for (_hbest = _hc++; _hc < _hend; _hc++) { \
+                if (cmp((base)[_hc], (base)[_hbest]) < 0) \
+                    _hbest = _hc; \
+            } \
+            if (cmp((base)[_hbest], _htmp) >= 0) \
+                break; \
+            (base)[_hi] = (base)[_hbest]; \
+            set_index((base)[_hi], _hi); \
+            _hi = _hbest; \
+        } \
+        (base)[_hi] = _htmp; \
+        set_index((base)[_hi], _hi); \
+    } while (0)
+
+#define _gcl_heap_make(_T, base, n, cmp, D, set_index) \
+    do { \
+        size_t _hn = (n), _hk; \
+        for (_hk = _hn > 1 ? (_hn - 2) / (D) + 1 : 0; _hk-- > 0; ) \
+            _gcl_heap_sift_down(_T, base, _hn, _hk, cmp, D, set_index); \
+    } while (0)
+
+#define gcl_make_heap(_C, range, cmp) \
+    _gcl_heap_make(_C##_elem_t, _C##_get_ptr(_C##_range_begin(range)), \
+                   _C##_range_length(range), cmp, 2, _gcl_heap_no_index)
+
+#define gcl_push_heap(_C, range, cmp) \
+    do { \
+        size_t _n = _C##_range_length(range); \
+        if (_n > 1) \
+            _gcl_heap_sift_up(_C##_elem_t, _C##_get_ptr(_C##_range_begin(range)), _n - 1, \
+                              cmp, 2, _gcl_heap_no_index); \
+    } while (0)
+
+#define gcl_pop_heap(_C, range, cmp) \
+    do { \
+        _C##_elem_t *_base = _C##_get_ptr(_C##_range_begin(range)), _tmp; \
+        size_t _n = _C##_range_length(range); \
+        if (_n > 1) { \
+            _tmp = _base[0]; \
+            _base[0] = _base[_n - 1]; \
+            _base[_n - 1] = _tmp; \
+            _gcl_heap_sift_down(_C##_elem_t, _base, _n - 1, 0, cmp, 2, _gcl_heap_no_index); \
+        } \
+    } while (0)
+
 #define gcl_generate(_C, range, generate_elem) \
     do { \
         int _i; \
         _C##_pos_t _pos; \
         gcl_for_each_pos_indexed(_C, _i, _pos, range) { \
-            _C##_set(_pos, (generate_elem)(_i)) \
+            _C##_set(_pos, (generate_elem)(_i)); \
         } \
     } while (0)
 
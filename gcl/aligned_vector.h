@@ -0,0 +1,206 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * An aligned vector keeps its data aligned to _align bytes across all
+ * resizes.  If _pad is nonzero, the capacity is always a multiple of _pad
+ * bytes, so that SIMD kernels of width _pad can process the last partial
+ * block up to _C##_padded_end without a scalar epilogue.
+ */
+
+#ifndef GCL_ALIGNED_VECTOR_H
+#define GCL_ALIGNED_VECTOR_H
+
+#include "vector.h"
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define _gcl_aligned_alloc(align, size) aligned_alloc(align, size)
+#else
+static inline void *_gcl_aligned_alloc(size_t align, size_t size)
+{
+    void *ptr;
+    int err;
+
+    /* posix_memalign rejects alignments smaller than a pointer. */
+    if (align < sizeof(void *))
+        align = sizeof(void *);
+
+    err = posix_memalign(&ptr, align, size);
+
+    if (err) {
+        errno = err;
+        return NULL;
+    }
+
+    return ptr;
+}
+#endif
+
+#define _gcl_round_up(n, m)             (((n) + (m) - 1) / (m) * (m))
+
+#define GCL_GENERATE_ALIGNED_VECTOR_TYPES(_C, _T, _align, _pad) \
+    GCL_GENERATE_VECTOR_TYPES(_C, _T) \
+\
+enum { \
+    _##_C##_alignment = (_align), \
+    _##_C##_padding = (_pad) \
+};
+
+#define GCL_GENERATE_ALIGNED_VECTOR_FUNCTIONS_STATIC(_C, _T) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, static inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_ALIGNED_VECTOR_FUNCTIONS_EXTERN_H(_C, _T) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_ALIGNED_VECTOR_FUNCTIONS_EXTERN_C(_C, _T) \
+    _gcl_stats_define_extern(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DEFS(_C, _T, ) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, )
+
+#define GCL_GENERATE_ALIGNED_VECTOR_FUNCTIONS_STATIC_EX(_C, _T, traits) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, static inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_ALIGNED_VECTOR_FUNCTIONS_EXTERN_H_EX(_C, _T, traits) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_ALIGNED_VECTOR_FUNCTIONS_EXTERN_C_EX(_C, _T, traits) \
+    GCL_GENERATE_ALIGNED_VECTOR_FUNCTIONS_EXTERN_C(_C, _T)
+
+#define GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_ALLOC_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DECLS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_ALIGNED_VECTOR_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_ALIGNED_VECTOR_ALLOC_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DEFS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs size_t _##_C##_pad_length(void); \
+_funcspecs _C##_pos_t _C##_padded_end(_C##_t *vec); \
+_funcspecs void _C##_fill_padding(_C##_t *vec, _T val); \
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2);
+
+#define GCL_GENERATE_ALIGNED_VECTOR_ALLOC_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *_##_C##_do_resize(struct _C *vec, size_t n) \
+{ \
+    assert(n >= _gcl_vector_length(vec) && n <= _C##_max_capacity()); \
+\
+    size_t length = _gcl_vector_length(vec); \
+    size_t size; \
+    _T *data; \
+\
+    if (n < GCL_VECTOR_MINIMAL_CAPACITY) \
+        n = GCL_VECTOR_MINIMAL_CAPACITY; \
+\
+    n = _gcl_round_up(n, _##_C##_pad_length()); \
+\
+    if (n == _gcl_vector_capacity(vec)) \
+        return vec->data; \
+\
+    size = _gcl_round_up(n * sizeof(_T), (size_t) _##_C##_alignment); \
+\
+    if (!(data = _gcl_aligned_alloc(_##_C##_alignment, size))) { \
+        GCL_ERROR(errno, "Allocating memory for vector failed"); \
+        return NULL; \
+    } \
+\
+    if (length) \
+        memcpy(data, vec->data, length * sizeof(_T)); \
+\
+    free(vec->data); \
+    _gcl_stats_resize(_C, n, length); \
+    vec->data = data; \
+    vec->data_end = data + n; \
+    vec->end = data + length; \
+    return data; \
+} \
+\
+_funcspecs _T *init_##_C(struct _C *vec, size_t n, void (*destroy_elem)(_T)) \
+{ \
+    assert((_##_C##_alignment & (_##_C##_alignment - 1)) == 0); \
+    assert(_##_C##_padding % sizeof(_T) == 0); \
+\
+    if (n < GCL_VECTOR_INITIAL_CAPACITY) \
+        n = GCL_VECTOR_INITIAL_CAPACITY; \
+\
+    *vec = (struct _C) { \
+        .data = NULL, \
+        .data_end = NULL, \
+        .end = NULL, \
+        .destroy_elem = destroy_elem, \
+        .policy = NULL \
+    }; \
+    return _##_C##_do_resize(vec, n); \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *vec) \
+{ \
+    _T *pos; \
+\
+    if (!_##_C##_trivial_elem(vec)) { \
+        _gcl_vector_for_each_pos(pos, vec) \
+            _##_C##_destroy_elem(vec, *pos); \
+    } \
+\
+    free(vec->data); \
+}
+
+#define GCL_GENERATE_ALIGNED_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs size_t _##_C##_pad_length(void) \
+{ \
+    return _##_C##_padding ? _##_C##_padding / sizeof(_T) : 1; \
+} \
+\
+_funcspecs _C##_pos_t _C##_padded_end(_C##_t *vec) \
+{ \
+    return vec->data + _gcl_round_up(_gcl_vector_length(vec), _##_C##_pad_length()); \
+} \
+\
+_funcspecs void _C##_fill_padding(_C##_t *vec, _T val) \
+{ \
+    _T *pos, *end = _C##_padded_end(vec); \
+\
+    for (pos = vec->end; pos != end; pos++) \
+        *pos = val; \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2) \
+{ \
+    struct _C tmp = *vec1; \
+    *vec1 = *vec2; \
+    *vec2 = tmp; \
+}
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Memory allocation for container storage.
+ *
+ * If GCL_MMAP_THRESHOLD is defined, blocks of at least that many bytes are
+ * backed by anonymous mappings and resized with mremap(MREMAP_MAYMOVE), so
+ * that growing a large container remaps its pages instead of copying them.
+ * mremap is only declared if _GNU_SOURCE is defined before the first system
+ * header is included; without it, large blocks are moved by copying.  If
+ * GCL_MMAP_HUGEPAGES is also defined, large blocks are marked for
+ * transparent huge pages with madvise(MADV_HUGEPAGE).
+ *
+ * Because the kind of a block is derived from its size, the size passed to
+ * _gcl_realloc and _gcl_free must be the one the block was allocated with.
+ * _gcl_usable_size returns a size that may be used in its place and covers
+ * the slack the allocator added to the block.
+ */
+
+#ifndef GCL_ALLOC_H
+#define GCL_ALLOC_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#define _gcl_malloc_usable_size(ptr, size)      malloc_usable_size(ptr)
+#else
+#define _gcl_malloc_usable_size(ptr, size)      (size)
+#endif
+
+#ifdef GCL_MMAP_THRESHOLD
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define _gcl_mmap_block(size)           ((size) >= (size_t) (GCL_MMAP_THRESHOLD))
+
+static inline size_t _gcl_page_round_up(size_t size)
+{
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    return (size + page_size - 1) / page_size * page_size;
+}
+
+static inline void _gcl_advise_block(void *ptr, size_t size)
+{
+#if defined(GCL_MMAP_HUGEPAGES) && defined(MADV_HUGEPAGE)
+    madvise(ptr, _gcl_page_round_up(size), MADV_HUGEPAGE);
+#else
+    (void) ptr;
+    (void) size;
+#endif
+}
+
+static inline void *_gcl_malloc(size_t size)
+{
+    void *ptr;
+
+    if (!_gcl_mmap_block(size))
+        return malloc(size);
+
+    ptr = mmap(NULL, _gcl_page_round_up(size), PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    _gcl_advise_block(ptr, size);
+    return ptr;
+}
+
+static inline void _gcl_free(void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    if (_gcl_mmap_block(size))
+        munmap(ptr, _gcl_page_round_up(size));
+    else
+        free(ptr);
+}
+
+static inline void *_gcl_realloc(void *ptr, size_t old_size, size_t new_size)
+{
+    void *new_ptr;
+
+    if (!ptr)
+        return _gcl_malloc(new_size);
+
+    if (!_gcl_mmap_block(old_size) && !_gcl_mmap_block(new_size))
+        return realloc(ptr, new_size);
+
+#ifdef MREMAP_MAYMOVE
+    if (_gcl_mmap_block(old_size) && _gcl_mmap_block(new_size)) {
+        new_ptr = mremap(ptr, _gcl_page_round_up(old_size),
+                         _gcl_page_round_up(new_size), MREMAP_MAYMOVE);
+
+        if (new_ptr == MAP_FAILED)
+            return NULL;
+
+        _gcl_advise_block(new_ptr, new_size);
+        return new_ptr;
+    }
+#endif
+
+    if (!(new_ptr = _gcl_malloc(new_size)))
+        return NULL;
+
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    _gcl_free(ptr, old_size);
+    return new_ptr;
+}
+
+static inline size_t _gcl_usable_size(void *ptr, size_t size)
+{
+    size_t usable;
+
+    if (_gcl_mmap_block(size))
+        return _gcl_page_round_up(size);
+
+    /* Do not let the slack turn a malloc block into an mmap block. */
+    usable = _gcl_malloc_usable_size(ptr, size);
+    return _gcl_mmap_block(usable) ? size : usable;
+}
+
+#else
+
+#define _gcl_malloc(size)                       malloc(size)
+#define _gcl_realloc(ptr, old_size, new_size)   realloc(ptr, new_size)
+#define _gcl_free(ptr, size)                    free(ptr)
+#define _gcl_usable_size(ptr, size)             _gcl_malloc_usable_size(ptr, size)
+
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Bit operations on 64-bit words, with compiler builtins where available.
+ * _gcl_ctz64 is undefined for zero.
+ *
+ * _gcl_bits_get and _gcl_bits_put access a field of width bits (0 to 64)
+ * starting at bit position pos of an array of words; a field may straddle
+ * two words.
+ */
+
+#ifndef GCL_BITS_H
+#define GCL_BITS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+static inline unsigned _gcl_ctz64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (unsigned) __builtin_ctzll(x);
+#else
+    unsigned n = 0;
+
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+
+    return n;
+#endif
+}
+
+static inline unsigned _gcl_popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return (unsigned) __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (unsigned) ((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* The position of the set bit of rank k in x, which must have more than k set bits. */
+static inline unsigned _gcl_select64(uint64_t x, unsigned k)
+{
+    while (k--)
+        x &= x - 1;
+
+    return _gcl_ctz64(x);
+}
+
+/* The number of bits needed to represent x, 0 for zero. */
+static inline unsigned _gcl_bit_width64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return x ? 64 - (unsigned) __builtin_clzll(x) : 0;
+#else
+    unsigned n = 0;
+
+    while (x) {
+        x >>= 1;
+        n++;
+    }
+
+    return n;
+#endif
+}
+
+#define _gcl_bits_mask(width) \
+    ((width) < 64 ? ((uint64_t) 1 << (width)) - 1 : ~(uint64_t) 0)
+
+static inline uint64_t _gcl_bits_get(const uint64_t *words, size_t pos, unsigned width)
+{
+    size_t i = pos / 64;
+    unsigned offset = pos % 64;
+    uint64_t x;
+
+    if (width == 0)
+        return 0;
+
+    x = words[i] >> offset;
+    if (offset + width > 64)
+        x |= words[i + 1] << (64 - offset);
+
+    return x & _gcl_bits_mask(width);
+}
+
+static inline void _gcl_bits_put(uint64_t *words, size_t pos, unsigned width, uint64_t x)
+{
+    size_t i = pos / 64;
+    unsigned offset = pos % 64;
+    uint64_t mask = _gcl_bits_mask(width);
+
+    if (width == 0)
+        return;
+
+    x &= mask;
+    words[i] = (words[i] & ~(mask << offset)) | (x << offset);
+    if (offset + width > 64)
+        words[i + 1] = (words[i + 1] & ~(mask >> (64 - offset))) | (x >> (64 - offset));
+}
+
+#endif
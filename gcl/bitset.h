@@ -0,0 +1,450 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A resizable bitset stored in a vector of 64-bit words, so it grows like
+ * a vector and follows its growth policy.  Bits past the length are always
+ * zero, which lets counting, searching and comparing work on whole words.
+ * The bitwise operations between two bitsets require equal lengths.
+ *
+ * _C##_find_first and _C##_find_next return the length of the bitset if
+ * there is no further set bit:
+ *
+ *     for (i = flags_find_first(&bs); i < flags_length(&bs); i = flags_find_next(&bs, i))
+ *         ...
+ *
+ * _C##_rank and _C##_select use an index of the number of set bits before
+ * every block of GCL_BITSET_RANK_BLOCK_WORDS words, built by
+ * _C##_build_rank.  With the index, rank is O(1) and select is a binary
+ * search over the blocks.  The index is not updated when the bitset is
+ * modified; it must be rebuilt before rank or select are used again.
+ */
+
+#ifndef GCL_BITSET_H
+#define GCL_BITSET_H
+
+#include "bits.h"
+#include "vector.h"
+
+#define GCL_BITSET_RANK_BLOCK_WORDS     (8)
+
+#define _gcl_bitset_num_words(n)        (((n) + 63) / 64)
+#define _gcl_bitset_word(i)             ((i) / 64)
+#define _gcl_bitset_bit(i)              ((uint64_t) 1 << ((i) % 64))
+
+#define GCL_GENERATE_BITSET_TYPES(_C) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_words, uint64_t) \
+\
+typedef struct _C _C##_t; \
+\
+struct _C { \
+    struct _C##_words words; \
+    size_t length; \
+    uint64_t *ranks; \
+    size_t num_ranks; \
+};
+
+#define GCL_GENERATE_BITSET_FUNCTIONS_STATIC(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_words, uint64_t) \
+    GCL_GENERATE_BITSET_LONG_FUNCTION_DECLS(_C, static) \
+    GCL_GENERATE_BITSET_SHORT_FUNCTION_DECLS(_C, static inline) \
+    GCL_GENERATE_BITSET_LONG_FUNCTION_DEFS(_C, static) \
+    GCL_GENERATE_BITSET_SHORT_FUNCTION_DEFS(_C, static inline)
+
+#define GCL_GENERATE_BITSET_FUNCTIONS_EXTERN_H(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_words, uint64_t) \
+    GCL_GENERATE_BITSET_LONG_FUNCTION_DECLS(_C, ) \
+    GCL_GENERATE_BITSET_SHORT_FUNCTION_DECLS(_C, inline) \
+    GCL_GENERATE_BITSET_SHORT_FUNCTION_DEFS(_C, inline)
+
+#define GCL_GENERATE_BITSET_FUNCTIONS_EXTERN_C(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_words, uint64_t) \
+    GCL_GENERATE_BITSET_LONG_FUNCTION_DEFS(_C, ) \
+    GCL_GENERATE_BITSET_SHORT_FUNCTION_DECLS(_C, )
+
+#define GCL_GENERATE_BITSET_LONG_FUNCTION_DECLS(_C, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *bs, size_t n); \
+_funcspecs void destroy_##_C(struct _C *bs); \
+_funcspecs void _##_C##_mask_tail(struct _C *bs); \
+_funcspecs bool _C##_resize(_C##_t *bs, size_t n); \
+_funcspecs bool _C##_insert_back(_C##_t *bs, bool val); \
+_funcspecs void _C##_set_range(_C##_t *bs, size_t begin, size_t end); \
+_funcspecs void _C##_reset_range(_C##_t *bs, size_t begin, size_t end); \
+_funcspecs void _C##_set_all(_C##_t *bs); \
+_funcspecs void _C##_reset_all(_C##_t *bs); \
+_funcspecs void _C##_and(_C##_t *dest, _C##_t *src); \
+_funcspecs void _C##_or(_C##_t *dest, _C##_t *src); \
+_funcspecs void _C##_xor(_C##_t *dest, _C##_t *src); \
+_funcspecs void _C##_andnot(_C##_t *dest, _C##_t *src); \
+_funcspecs bool _C##_equal(_C##_t *bs1, _C##_t *bs2); \
+_funcspecs size_t _C##_count(_C##_t *bs); \
+_funcspecs size_t _##_C##_find_from(struct _C *bs, size_t i); \
+_funcspecs bool _C##_build_rank(_C##_t *bs); \
+_funcspecs size_t _C##_select(_C##_t *bs, size_t k); \
+_funcspecs void _C##_clear(_C##_t *bs); \
+_funcspecs void _C##_swap(_C##_t *bs1, _C##_t *bs2);
+
+#define GCL_GENERATE_BITSET_SHORT_FUNCTION_DECLS(_C, _funcspecs) \
+\
+_funcspecs size_t _C##_length(_C##_t *bs); \
+_funcspecs bool _C##_empty(_C##_t *bs); \
+_funcspecs uint64_t *_C##_data(_C##_t *bs); \
+_funcspecs bool _C##_test(_C##_t *bs, size_t i); \
+_funcspecs void _C##_set(_C##_t *bs, size_t i); \
+_funcspecs void _C##_reset(_C##_t *bs, size_t i); \
+_funcspecs void _C##_flip(_C##_t *bs, size_t i); \
+_funcspecs void _C##_assign(_C##_t *bs, size_t i, bool val); \
+_funcspecs size_t _C##_find_first(_C##_t *bs); \
+_funcspecs size_t _C##_find_next(_C##_t *bs, size_t i); \
+_funcspecs size_t _C##_rank(_C##_t *bs, size_t i);
+
+#define GCL_GENERATE_BITSET_LONG_FUNCTION_DEFS(_C, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *bs, size_t n) \
+{ \
+    bs->length = 0; \
+    bs->ranks = NULL; \
+    bs->num_ranks = 0; \
+\
+    if (!init_##_C##_words(&bs->words, _gcl_bitset_num_words(n), NULL)) \
+        return false; \
+\
+    if (!_C##_resize(bs, n)) { \
+        destroy_##_C##_words(&bs->words); \
+        return false; \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *bs) \
+{ \
+    destroy_##_C##_words(&bs->words); \
+    _gcl_free(bs->ranks, bs->num_ranks * sizeof(uint64_t)); \
+} \
+\
+_funcspecs void _##_C##_mask_tail(struct _C *bs) \
+{ \
+    if (bs->length % 64) \
+        bs->words.data[_gcl_bitset_word(bs->length)] &= _gcl_bitset_bit(bs->length) - 1; \
+} \
+\
+_funcspecs bool _C##_resize(_C##_t *bs, size_t n) \
+{ \
+    size_t num_words = _gcl_bitset_num_words(n); \
+    size_t length = _gcl_vector_length(&bs->words); \
+\
+    if (num_words > length) { \
+        if (!_C##_words_reserve(&bs->words, num_words)) \
+            return false; \
+        memset(bs->words.end, 0, (num_words - length) * sizeof(uint64_t)); \
+    } \
+\
+    bs->words.end = bs->words.data + num_words; \
+    bs->length = n; \
+    _##_C##_mask_tail(bs); \
+    return true; \
+} \
+\
+_funcspecs bool _C##_insert_back(_C##_t *bs, bool val) \
+{ \
+    if (bs->length % 64 == 0 && !_C##_words_insert_back(&bs->words, 0)) \
+        return false; \
+\
+    bs->length++; \
+    _C##_assign(bs, bs->length - 1, val); \
+    return true; \
+} \
+\
+_funcspecs void _C##_set_range(_C##_t *bs, size_t begin, size_t end) \
+{ \
+    assert(begin <= end && end <= bs->length); \
+\
+    if (begin == end) \
+        return; \
+\
+    size_t i = _gcl_bitset_word(begin), last = _gcl_bitset_word(end - 1); \
+    uint64_t first_mask = ~(uint64_t) 0 << (begin % 64); \
+    uint64_t last_mask = ~(uint64_t) 0 >> (63 - (end - 1) % 64); \
+\
+    if (i == last) { \
+        bs->words.data[i] |= first_mask & last_mask; \
+        return; \
+    } \
+\
+    bs->words.data[i++] |= first_mask; \
+    for (; i < last; i++) \
+        bs->words.data[i] = ~(uint64_t) 0; \
+    bs->words.data[last] |= last_mask; \
+} \
+\
+_funcspecs void _C##_reset_range(_C##_t *bs, size_t begin, size_t end) \
+{ \
+    assert(begin <= end && end <= bs->length); \
+\
+    if (begin == end) \
+        return; \
+\
+    size_t i = _gcl_bitset_word(begin), last = _gcl_bitset_word(end - 1); \
+    uint64_t first_mask = ~(uint64_t) 0 << (begin % 64); \
+    uint64_t last_mask = ~(uint64_t) 0 >> (63 - (end - 1) % 64); \
+\
+    if (i == last) { \
+        bs->words.data[i] &= ~(first_mask & last_mask); \
+        return; \
+    } \
+\
+    bs->words.data[i++] &= ~first_mask; \
+    for (; i < last; i++) \
+        bs->words.data[i] = 0; \
+    bs->words.data[last] &= ~last_mask; \
+} \
+\
+_funcspecs void _C##_set_all(_C##_t *bs) \
+{ \
+    memset(bs->words.data, 0xff, _gcl_vector_length(&bs->words) * sizeof(uint64_t)); \
+    _##_C##_mask_tail(bs); \
+} \
+\
+_funcspecs void _C##_reset_all(_C##_t *bs) \
+{ \
+    memset(bs->words.data, 0, _gcl_vector_length(&bs->words) * sizeof(uint64_t)); \
+} \
+\
+_funcspecs void _C##_and(_C##_t *dest, _C##_t *src) \
+{ \
+    size_t n = _gcl_vector_length(&dest->words), i; \
+    uint64_t *d = dest->words.data; \
+    const uint64_t *s = src->words.data; \
+\
+    assert(dest->length == src->length); \
+\
+    for (i = 0; i < n; i++) \
+        d[i] &= s[i]; \
+} \
+\
+_funcspecs void _C##_or(_C##_t *dest, _C##_t *src) \
+{ \
+    size_t n = _gcl_vector_length(&dest->words), i; \
+    uint64_t *d = dest->words.data; \
+    const uint64_t *s = src->words.data; \
+\
+    assert(dest->length == src->length); \
+\
+    for (i = 0; i < n; i++) \
+        d[i] |= s[i]; \
+} \
+\
+_funcspecs void _C##_xor(_C##_t *dest, _C##_t *src) \
+{ \
+    size_t n = _gcl_vector_length(&dest->words), i; \
+    uint64_t *d = dest->words.data; \
+    const uint64_t *s = src->words.data; \
+\
+    assert(dest->length == src->length); \
+\
+    for (i = 0; i < n; i++) \
+        d[i] ^= s[i]; \
+} \
+\
+_funcspecs void _C##_andnot(_C##_t *dest, _C##_t *src) \
+{ \
+    size_t n = _gcl_vector_length(&dest->words), i; \
+    uint64_t *d = dest->words.data; \
+    const uint64_t *s = src->words.data; \
+\
+    assert(dest->length == src->length); \
+\
+    for (i = 0; i < n; i++) \
+        d[i] &= ~s[i]; \
+} \
+\
+_funcspecs bool _C##_equal(_C##_t *bs1, _C##_t *bs2) \
+{ \
+    return bs1->length == bs2->length && \
+        memcmp(bs1->words.data, bs2->words.data, \
+               _gcl_vector_length(&bs1->words) * sizeof(uint64_t)) == 0; \
+} \
+\
+_funcspecs size_t _C##_count(_C##_t *bs) \
+{ \
+    size_t n = _gcl_vector_length(&bs->words), count = 0, i; \
+\
+    for (i = 0; i < n; i++) \
+        count += _gcl_popcount64(bs->words.data[i]); \
+\
+    return count; \
+} \
+\
+_funcspecs size_t _##_C##_find_from(struct _C *bs, size_t i) \
+{ \
+    size_t n = _gcl_vector_length(&bs->words), w; \
+    uint64_t x; \
+\
+    if (i >= bs->length) \
+        return bs->length; \
+\
+    w = _gcl_bitset_word(i); \
+    x = bs->words.data[w] & (~(uint64_t) 0 << (i % 64)); \
+\
+    while (!x) { \
+        if (++w == n) \
+            return bs->length; \
+        x = bs->words.data[w]; \
+    } \
+\
+    return w * 64 + _gcl_ctz64(x); \
+} \
+\
+_funcspecs bool _C##_build_rank(_C##_t *bs) \
+{ \
+    size_t n = _gcl_vector_length(&bs->words), count = 0, i; \
+    size_t num_ranks = n / GCL_BITSET_RANK_BLOCK_WORDS + 1; \
+    uint64_t *ranks; \
+\
+    if (num_ranks != bs->num_ranks) { \
+        if (!(ranks = _gcl_realloc(bs->ranks, bs->num_ranks * sizeof(uint64_t), \
+                                   num_ranks * sizeof(uint64_t)))) { \
+            GCL_ERROR(errno, "Allocating memory for rank index failed"); \
+            return false; \
+        } \
+        bs->ranks = ranks; \
+        bs->num_ranks = num_ranks; \
+    } \
+\
+    for (i = 0; i < n; i++) { \
+        if (i % GCL_BITSET_RANK_BLOCK_WORDS == 0) \
+            bs->ranks[i / GCL_BITSET_RANK_BLOCK_WORDS] = count; \
+        count += _gcl_popcount64(bs->words.data[i]); \
+    } \
+\
+    if (n % GCL_BITSET_RANK_BLOCK_WORDS == 0) \
+        bs->ranks[num_ranks - 1] = count; \
+\
+    return true; \
+} \
+\
+_funcspecs size_t _C##_select(_C##_t *bs, size_t k) \
+{ \
+    size_t n = _gcl_vector_length(&bs->words); \
+    size_t lo = 0, hi = bs->num_ranks, mid, w; \
+    unsigned count; \
+\
+    assert(bs->ranks); \
+\
+    while (hi - lo > 1) { \
+        mid = lo + (hi - lo) / 2; \
+        if (bs->ranks[mid] <= k) \
+            lo = mid; \
+        else \
+            hi = mid; \
+    } \
+\
+    k -= bs->ranks[lo]; \
+\
+    for (w = lo * GCL_BITSET_RANK_BLOCK_WORDS; w < n; w++) { \
+        count = _gcl_popcount64(bs->words.data[w]); \
+        if (k < count) \
+            return w * 64 + _gcl_select64(bs->words.data[w], (unsigned) k); \
+        k -= count; \
+    } \
+\
+    return bs->length; \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *bs) \
+{ \
+    _C##_words_clear(&bs->words); \
+    bs->length = 0; \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *bs1, _C##_t *bs2) \
+{ \
+    struct _C tmp = *bs1; \
+    *bs1 = *bs2; \
+    *bs2 = tmp; \
+}
+
+#define GCL_GENERATE_BITSET_SHORT_FUNCTION_DEFS(_C, _funcspecs) \
+\
+_funcspecs size_t _C##_length(_C##_t *bs) \
+{ \
+    return bs->length; \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *bs) \
+{ \
+    return bs->length == 0; \
+} \
+\
+_funcspecs uint64_t *_C##_data(_C##_t *bs) \
+{ \
+    return bs->words.data; \
+} \
+\
+_funcspecs bool _C##_test(_C##_t *bs, size_t i) \
+{ \
+    assert(i < bs->length); \
+    return (bs->words.data[_gcl_bitset_word(i)] & _gcl_bitset_bit(i)) != 0; \
+} \
+\
+_funcspecs void _C##_set(_C##_t *bs, size_t i) \
+{ \
+    assert(i < bs->length); \
+    bs->words.data[_gcl_bitset_word(i)] |= _gcl_bitset_bit(i); \
+} \
+\
+_funcspecs void _C##_reset(_C##_t *bs, size_t i) \
+{ \
+    assert(i < bs->length); \
+    bs->words.data[_gcl_bitset_word(i)] &= ~_gcl_bitset_bit(i); \
+} \
+\
+_funcspecs void _C##_flip(_C##_t *bs, size_t i) \
+{ \
+    assert(i < bs->length); \
+    bs->words.data[_gcl_bitset_word(i)] ^= _gcl_bitset_bit(i); \
+} \
+\
+_funcspecs void _C##_assign(_C##_t *bs, size_t i, bool val) \
+{ \
+    if (val) \
+        _C##_set(bs, i); \
+    else \
+        _C##_reset(bs, i); \
+} \
+\
+_funcspecs size_t _C##_find_first(_C##_t *bs) \
+{ \
+    return _##_C##_find_from(bs, 0); \
+} \
+\
+_funcspecs size_t _C##_find_next(_C##_t *bs, size_t i) \
+{ \
+    return _##_C##_find_from(bs, i + 1); \
+} \
+\
+_funcspecs size_t _C##_rank(_C##_t *bs, size_t i) \
+{ \
+    size_t w = _gcl_bitset_word(i), j; \
+    size_t rank; \
+\
+    assert(bs->ranks && i <= bs->length); \
+\
+    j = w - w % GCL_BITSET_RANK_BLOCK_WORDS; \
+    rank = bs->ranks[j / GCL_BITSET_RANK_BLOCK_WORDS]; \
+    for (; j < w; j++) \
+        rank += _gcl_popcount64(bs->words.data[j]); \
+\
+    if (i % 64) \
+        rank += _gcl_popcount64(bs->words.data[w] & (_gcl_bitset_bit(i) - 1)); \
+\
+    return rank; \
+}
+
+#endif
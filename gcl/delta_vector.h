@@ -0,0 +1,459 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A compressed, append-only vector of sorted unsigned integers.  Elements
+ * are grouped into blocks of GCL_DELTA_VECTOR_BLOCK_LENGTH.  A block stores
+ * its first element in a header and the differences between consecutive
+ * elements bit-packed with the smallest width that holds the largest
+ * difference in the block (frame of reference).  Elements are appended to
+ * an uncompressed tail block that is compressed once it is full.
+ *
+ * The block headers serve as skip pointers: _C##_lower_bound and
+ * _C##_contains binary-search the headers and then decode at most one
+ * block.  _C##_at decodes from the start of the element's block.
+ * _C##_decode_block decodes a whole block into an array in two simple
+ * loops, unpacking and then summing the differences, which is the fast way
+ * to scan many elements.
+ *
+ * Positions carry the value of their element, so iterating over a range
+ * with _C##_forward and _C##_get is O(1) per element.  Positions can only
+ * move forward.
+ */
+
+#ifndef GCL_DELTA_VECTOR_H
+#define GCL_DELTA_VECTOR_H
+
+#include "bits.h"
+#include "vector.h"
+
+#ifndef GCL_DELTA_VECTOR_BLOCK_LENGTH
+#define GCL_DELTA_VECTOR_BLOCK_LENGTH   (128)
+#endif
+
+struct gcl_delta_block {
+    uint64_t first;
+    size_t offset;
+    unsigned width;
+};
+
+#define GCL_GENERATE_DELTA_VECTOR_TYPES(_C) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_words, uint64_t) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_blocks, struct gcl_delta_block) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_pos _C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef uint64_t _C##_elem_t; \
+\
+struct _C { \
+    struct _C##_words words; \
+    struct _C##_blocks blocks; \
+    size_t num_bits; \
+    size_t tail_length; \
+    uint64_t tail[GCL_DELTA_VECTOR_BLOCK_LENGTH]; \
+}; \
+\
+struct _C##_pos { \
+    struct _C *vec; \
+    size_t i; \
+    uint64_t val; \
+}; \
+\
+struct _C##_range { \
+    struct _C##_pos begin; \
+    struct _C##_pos end; \
+};
+
+#define GCL_GENERATE_DELTA_VECTOR_FUNCTIONS_STATIC(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_words, uint64_t) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_blocks, struct gcl_delta_block) \
+    GCL_GENERATE_DELTA_VECTOR_LONG_FUNCTION_DECLS(_C, static) \
+    GCL_GENERATE_DELTA_VECTOR_SHORT_FUNCTION_DECLS(_C, static inline) \
+    GCL_GENERATE_DELTA_VECTOR_LONG_FUNCTION_DEFS(_C, static) \
+    GCL_GENERATE_DELTA_VECTOR_SHORT_FUNCTION_DEFS(_C, static inline)
+
+#define GCL_GENERATE_DELTA_VECTOR_FUNCTIONS_EXTERN_H(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_words, uint64_t) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_blocks, struct gcl_delta_block) \
+    GCL_GENERATE_DELTA_VECTOR_LONG_FUNCTION_DECLS(_C, ) \
+    GCL_GENERATE_DELTA_VECTOR_SHORT_FUNCTION_DECLS(_C, inline) \
+    GCL_GENERATE_DELTA_VECTOR_SHORT_FUNCTION_DEFS(_C, inline)
+
+#define GCL_GENERATE_DELTA_VECTOR_FUNCTIONS_EXTERN_C(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_words, uint64_t) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_blocks, struct gcl_delta_block) \
+    GCL_GENERATE_DELTA_VECTOR_LONG_FUNCTION_DEFS(_C, ) \
+    GCL_GENERATE_DELTA_VECTOR_SHORT_FUNCTION_DECLS(_C, )
+
+#define GCL_GENERATE_DELTA_VECTOR_LONG_FUNCTION_DECLS(_C, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *vec, size_t n); \
+_funcspecs void destroy_##_C(struct _C *vec); \
+_funcspecs bool _##_C##_compress_tail(struct _C *vec); \
+_funcspecs bool _C##_insert_back(_C##_t *vec, uint64_t val); \
+_funcspecs bool _C##_insert_back_array(_C##_t *vec, const uint64_t *src, size_t n); \
+_funcspecs uint64_t _C##_at(_C##_t *vec, size_t i); \
+_funcspecs size_t _C##_decode_block(_C##_t *vec, size_t b, uint64_t *dest); \
+_funcspecs _C##_pos_t _C##_lower_bound(_C##_t *vec, uint64_t val); \
+_funcspecs bool _C##_contains(_C##_t *vec, uint64_t val); \
+_funcspecs void _C##_clear(_C##_t *vec); \
+_funcspecs void _C##_shrink(_C##_t *vec); \
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2);
+
+#define GCL_GENERATE_DELTA_VECTOR_SHORT_FUNCTION_DECLS(_C, _funcspecs) \
+\
+_funcspecs size_t _##_C##_num_full_blocks(struct _C *vec); \
+_funcspecs size_t _C##_length(_C##_t *vec); \
+_funcspecs bool _C##_empty(_C##_t *vec); \
+_funcspecs size_t _C##_num_blocks(_C##_t *vec); \
+_funcspecs uint64_t _C##_front(_C##_t *vec); \
+_funcspecs uint64_t _C##_back(_C##_t *vec); \
+_funcspecs _C##_pos_t _C##_begin(_C##_t *vec); \
+_funcspecs _C##_pos_t _C##_end(_C##_t *vec); \
+_funcspecs bool _C##_at_begin(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs bool _C##_at_end(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos); \
+_funcspecs void _C##_forward(_C##_pos_t *pos); \
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end); \
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range); \
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range); \
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_all(_C##_t *vec); \
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs size_t _C##_range_length(_C##_range_t range); \
+_funcspecs bool _C##_range_empty(_C##_range_t range); \
+_funcspecs uint64_t _C##_get(_C##_pos_t pos);
+
+#define GCL_GENERATE_DELTA_VECTOR_LONG_FUNCTION_DEFS(_C, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *vec, size_t n) \
+{ \
+    vec->num_bits = 0; \
+    vec->tail_length = 0; \
+\
+    if (!init_##_C##_words(&vec->words, 0, NULL)) \
+        return false; \
+\
+    if (!init_##_C##_blocks(&vec->blocks, n / GCL_DELTA_VECTOR_BLOCK_LENGTH, NULL)) { \
+        destroy_##_C##_words(&vec->words); \
+        return false; \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *vec) \
+{ \
+    destroy_##_C##_words(&vec->words); \
+    destroy_##_C##_blocks(&vec->blocks); \
+} \
+\
+_funcspecs bool _##_C##_compress_tail(struct _C *vec) \
+{ \
+    const size_t n = GCL_DELTA_VECTOR_BLOCK_LENGTH; \
+    const uint64_t *src = vec->tail; \
+    struct gcl_delta_block block; \
+    uint64_t bits = 0; \
+    size_t num_words, length, i; \
+\
+    assert(vec->tail_length == n); \
+\
+    for (i = 1; i < n; i++) \
+        bits |= src[i] - src[i - 1]; \
+\
+    block.first = src[0]; \
+    block.offset = vec->num_bits; \
+    block.width = _gcl_bit_width64(bits); \
+\
+    num_words = (vec->num_bits + (n - 1) * block.width + 63) / 64; \
+    length = _gcl_vector_length(&vec->words); \
+\
+    if (!_C##_words_reserve(&vec->words, num_words) || \
+        !_C##_blocks_insert_back(&vec->blocks, block)) \
+        return false; \
+\
+    memset(vec->words.end, 0, (num_words - length) * sizeof(uint64_t)); \
+    vec->words.end = vec->words.data + num_words; \
+\
+    for (i = 1; i < n; i++) \
+        _gcl_bits_put(vec->words.data, block.offset + (i - 1) * block.width, block.width, \
+                      src[i] - src[i - 1]); \
+\
+    vec->num_bits += (n - 1) * block.width; \
+    vec->tail_length = 0; \
+    return true; \
+} \
+\
+_funcspecs bool _C##_insert_back(_C##_t *vec, uint64_t val) \
+{ \
+    assert(_C##_empty(vec) || val >= _C##_back(vec)); \
+\
+    if (vec->tail_length == GCL_DELTA_VECTOR_BLOCK_LENGTH && !_##_C##_compress_tail(vec)) \
+        return false; \
+\
+    vec->tail[vec->tail_length++] = val; \
+    return true; \
+} \
+\
+_funcspecs bool _C##_insert_back_array(_C##_t *vec, const uint64_t *src, size_t n) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) { \
+        if (!_C##_insert_back(vec, src[i])) \
+            return false; \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs uint64_t _C##_at(_C##_t *vec, size_t i) \
+{ \
+    size_t b = i / GCL_DELTA_VECTOR_BLOCK_LENGTH, j = i % GCL_DELTA_VECTOR_BLOCK_LENGTH, k; \
+    const struct gcl_delta_block *block; \
+    uint64_t val; \
+\
+    assert(i < _C##_length(vec)); \
+\
+    if (b == _##_C##_num_full_blocks(vec)) \
+        return vec->tail[j]; \
+\
+    block = &vec->blocks.data[b]; \
+    val = block->first; \
+    for (k = 0; k < j; k++) \
+        val += _gcl_bits_get(vec->words.data, block->offset + k * block->width, block->width); \
+\
+    return val; \
+} \
+\
+_funcspecs size_t _C##_decode_block(_C##_t *vec, size_t b, uint64_t *dest) \
+{ \
+    const size_t n = GCL_DELTA_VECTOR_BLOCK_LENGTH; \
+    const struct gcl_delta_block *block; \
+    size_t i; \
+\
+    assert(b < _C##_num_blocks(vec)); \
+\
+    if (b == _##_C##_num_full_blocks(vec)) { \
+        memcpy(dest, vec->tail, vec->tail_length * sizeof(uint64_t)); \
+        return vec->tail_length; \
+    } \
+\
+    block = &vec->blocks.data[b]; \
+    dest[0] = block->first; \
+    for (i = 1; i < n; i++) \
+        dest[i] = _gcl_bits_get(vec->words.data, block->offset + (i - 1) * block->width, \
+                                block->width); \
+    for (i = 1; i < n; i++) \
+        dest[i] += dest[i - 1]; \
+\
+    return n; \
+} \
+\
+_funcspecs _C##_pos_t _C##_lower_bound(_C##_t *vec, uint64_t val) \
+{ \
+    size_t num_blocks = _##_C##_num_full_blocks(vec); \
+    size_t lo = 0, hi = num_blocks, mid; \
+    _C##_pos_t pos; \
+\
+    /* Find the last block whose first element is less than val. */ \
+    if (vec->tail_length > 0 && vec->tail[0] < val) { \
+        lo = num_blocks; \
+    } else { \
+        while (lo < hi) { \
+            mid = lo + (hi - lo) / 2; \
+            if (vec->blocks.data[mid].first < val) \
+                lo = mid + 1; \
+            else \
+                hi = mid; \
+        } \
+        if (lo == 0) \
+            return _C##_begin(vec); \
+        lo--; \
+    } \
+\
+    pos.vec = vec; \
+    pos.i = lo * GCL_DELTA_VECTOR_BLOCK_LENGTH; \
+    pos.val = lo < num_blocks ? vec->blocks.data[lo].first : vec->tail[0]; \
+\
+    while (!_C##_at_end(vec, pos) && pos.val < val) \
+        _C##_forward(&pos); \
+\
+    return pos; \
+} \
+\
+_funcspecs bool _C##_contains(_C##_t *vec, uint64_t val) \
+{ \
+    _C##_pos_t pos = _C##_lower_bound(vec, val); \
+    return !_C##_at_end(vec, pos) && pos.val == val; \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *vec) \
+{ \
+    _C##_words_clear(&vec->words); \
+    _C##_blocks_clear(&vec->blocks); \
+    vec->num_bits = 0; \
+    vec->tail_length = 0; \
+} \
+\
+_funcspecs void _C##_shrink(_C##_t *vec) \
+{ \
+    _C##_words_shrink(&vec->words); \
+    _C##_blocks_shrink(&vec->blocks); \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2) \
+{ \
+    struct _C tmp = *vec1; \
+    *vec1 = *vec2; \
+    *vec2 = tmp; \
+}
+
+#define GCL_GENERATE_DELTA_VECTOR_SHORT_FUNCTION_DEFS(_C, _funcspecs) \
+\
+_funcspecs size_t _##_C##_num_full_blocks(struct _C *vec) \
+{ \
+    return _gcl_vector_length(&vec->blocks); \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *vec) \
+{ \
+    return _##_C##_num_full_blocks(vec) * GCL_DELTA_VECTOR_BLOCK_LENGTH + vec->tail_length; \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *vec) \
+{ \
+    return _C##_length(vec) == 0; \
+} \
+\
+_funcspecs size_t _C##_num_blocks(_C##_t *vec) \
+{ \
+    return _##_C##_num_full_blocks(vec) + (vec->tail_length > 0); \
+} \
+\
+_funcspecs uint64_t _C##_front(_C##_t *vec) \
+{ \
+    assert(!_C##_empty(vec)); \
+    return _##_C##_num_full_blocks(vec) > 0 ? vec->blocks.data[0].first : vec->tail[0]; \
+} \
+\
+_funcspecs uint64_t _C##_back(_C##_t *vec) \
+{ \
+    assert(!_C##_empty(vec)); \
+    return vec->tail_length > 0 ? vec->tail[vec->tail_length - 1] \
+                                : _C##_at(vec, _C##_length(vec) - 1); \
+} \
+\
+_funcspecs _C##_pos_t _C##_begin(_C##_t *vec) \
+{ \
+    return (struct _C##_pos) { vec, 0, _C##_empty(vec) ? 0 : _C##_front(vec) }; \
+} \
+\
+_funcspecs _C##_pos_t _C##_end(_C##_t *vec) \
+{ \
+    return (struct _C##_pos) { vec, _C##_length(vec), 0 }; \
+} \
+\
+_funcspecs bool _C##_at_begin(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    (void) vec; \
+    return pos.i == 0; \
+} \
+\
+_funcspecs bool _C##_at_end(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return pos.i == _C##_length(vec); \
+} \
+\
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos) \
+{ \
+    _C##_forward(&pos); \
+    return pos; \
+} \
+\
+_funcspecs void _C##_forward(_C##_pos_t *pos) \
+{ \
+    struct _C *vec = pos->vec; \
+    size_t i = ++pos->i; \
+    size_t b = i / GCL_DELTA_VECTOR_BLOCK_LENGTH, j = i % GCL_DELTA_VECTOR_BLOCK_LENGTH; \
+    const struct gcl_delta_block *block; \
+\
+    if (i >= _C##_length(vec)) \
+        return; \
+\
+    if (b == _##_C##_num_full_blocks(vec)) { \
+        pos->val = vec->tail[j]; \
+    } else if (j == 0) { \
+        pos->val = vec->blocks.data[b].first; \
+    } else { \
+        block = &vec->blocks.data[b]; \
+        pos->val += _gcl_bits_get(vec->words.data, block->offset + (j - 1) * block->width, \
+                                  block->width); \
+    } \
+} \
+\
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end) \
+{ \
+    return (struct _C##_range) { begin, end }; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range) \
+{ \
+    return range.begin; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range) \
+{ \
+    return range.end; \
+} \
+\
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.begin.i; \
+} \
+\
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.end.i; \
+} \
+\
+_funcspecs _C##_range_t _C##_all(_C##_t *vec) \
+{ \
+    return (struct _C##_range) { _C##_begin(vec), _C##_end(vec) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { pos, _C##_end(vec) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { _C##_begin(vec), pos }; \
+} \
+\
+_funcspecs size_t _C##_range_length(_C##_range_t range) \
+{ \
+    assert(range.begin.i <= range.end.i); \
+    return range.end.i - range.begin.i; \
+} \
+\
+_funcspecs bool _C##_range_empty(_C##_range_t range) \
+{ \
+    return range.begin.i == range.end.i; \
+} \
+\
+_funcspecs uint64_t _C##_get(_C##_pos_t pos) \
+{ \
+    assert(pos.i < _C##_length(pos.vec)); \
+    return pos.val; \
+}
+
+#endif
@@ -0,0 +1,690 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A gap buffer keeps its elements in one block with a gap of unused slots
+ * at the cursor: the elements before the cursor are at the start of the
+ * block and the elements after it at the end.  Inserting and removing at
+ * the cursor is O(1); moving the cursor moves the elements between the old
+ * and the new cursor position across the gap.  Insertions and removals at
+ * arbitrary positions first move the cursor there, so runs of edits close
+ * to each other stay cheap regardless of the length of the buffer.
+ *
+ * Positions are indices and remain valid when the cursor moves.  The
+ * elements are stored in at most two contiguous spans, returned by
+ * _C##_first_span and _C##_second_span, which is the fast way to iterate
+ * over all of them.
+ */
+
+#ifndef GCL_GAP_BUFFER_H
+#define GCL_GAP_BUFFER_H
+
+#ifndef GCL_ERROR
+#define GCL_ERROR(errnum, ...)
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "growth.h"
+#include "stats.h"
+#include "traits.h"
+
+#define GCL_GAP_BUFFER_MINIMAL_CAPACITY     (16)
+#define GCL_GAP_BUFFER_INITIAL_CAPACITY     (16)
+#define GCL_GAP_BUFFER_GROWTH_FACTOR        (2)
+
+#define _gcl_gap_buffer_capacity(buf)   ((size_t) ((buf)->data_end - (buf)->data))
+#define _gcl_gap_buffer_length(buf) \
+    ((size_t) (((buf)->gap_begin - (buf)->data) + ((buf)->data_end - (buf)->gap_end)))
+#define _gcl_gap_buffer_cursor(buf)     ((size_t) ((buf)->gap_begin - (buf)->data))
+#define _gcl_gap_buffer_after(buf)      ((size_t) ((buf)->data_end - (buf)->gap_end))
+
+#define _gcl_gap_buffer_for_each_ptr(ptr, buf) \
+    for ((ptr) = (buf)->gap_begin == (buf)->data ? (buf)->gap_end : (buf)->data; \
+         (ptr) != (buf)->data_end; \
+         (++(ptr) == (buf)->gap_begin ? (ptr) = (buf)->gap_end : (ptr)))
+
+#define GCL_GENERATE_GAP_BUFFER_TYPES(_C, _T) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_pos _C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef _T _C##_elem_t; \
+\
+struct _C##_pos { \
+    struct _C *buf; \
+    size_t i; \
+}; \
+\
+struct _C##_range { \
+    struct _C##_pos begin; \
+    struct _C##_pos end; \
+}; \
+\
+struct _C { \
+    _T *data; \
+    _T *data_end; \
+    _T *gap_begin; \
+    _T *gap_end; \
+    void (*destroy_elem)(_T); \
+    const struct gcl_growth_policy *policy; \
+};
+
+#define GCL_GENERATE_GAP_BUFFER_FUNCTIONS_STATIC(_C, _T) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, static inline) \
+    GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_GAP_BUFFER_FUNCTIONS_EXTERN_H(_C, _T) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, inline) \
+    GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_GAP_BUFFER_FUNCTIONS_EXTERN_C(_C, _T) \
+    _gcl_stats_define_extern(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DEFS(_C, _T, ) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DECLS(_C, _T, )
+
+#define GCL_GENERATE_GAP_BUFFER_FUNCTIONS_STATIC_EX(_C, _T, traits) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, static inline) \
+    GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_GAP_BUFFER_FUNCTIONS_EXTERN_H_EX(_C, _T, traits) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, inline) \
+    GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_GAP_BUFFER_FUNCTIONS_EXTERN_C_EX(_C, _T, traits) \
+    GCL_GENERATE_GAP_BUFFER_FUNCTIONS_EXTERN_C(_C, _T)
+
+#define GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *_##_C##_do_resize(struct _C *buf, size_t n); \
+_funcspecs _T *_##_C##_grow(struct _C *buf, size_t n); \
+_funcspecs void _##_C##_shrink_by_policy(struct _C *buf); \
+_funcspecs _T *init_##_C(struct _C *buf, size_t n, void (*destroy_elem)(_T)); \
+_funcspecs void destroy_##_C(struct _C *buf); \
+_funcspecs void _C##_move_cursor(_C##_t *buf, size_t i); \
+_funcspecs bool _C##_insert_at_cursor(_C##_t *buf, _T val); \
+_funcspecs bool _C##_insert_array_at_cursor(_C##_t *buf, const _C##_elem_t *src, size_t n); \
+_funcspecs void _C##_remove_before_cursor(_C##_t *buf); \
+_funcspecs void _C##_remove_after_cursor(_C##_t *buf); \
+_funcspecs void _C##_remove_range(_C##_t *buf, size_t begin, size_t end); \
+_funcspecs _C##_pos_t _C##_insert(_C##_t *buf, _C##_pos_t pos, _T val); \
+_funcspecs _C##_pos_t _C##_release(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_remove(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs void _C##_release_tail(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs void _C##_clear(_C##_t *buf); \
+_funcspecs void _C##_swap(_C##_t *buf1, _C##_t *buf2);
+
+#define GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs _C##_pos_t _##_C##_pos(struct _C *buf, size_t i); \
+_funcspecs bool _##_C##_valid_index(struct _C *buf, size_t i); \
+_funcspecs bool _##_C##_valid_pos(struct _C *buf, struct _C##_pos pos); \
+_funcspecs _T *_##_C##_ptr_of_index(struct _C *buf, size_t i); \
+_funcspecs void _##_C##_move_data(_T *begin, _T *end, _T *dest); \
+_funcspecs size_t _C##_length(_C##_t *buf); \
+_funcspecs bool _C##_empty(_C##_t *buf); \
+_funcspecs size_t _C##_capacity(_C##_t *buf); \
+_funcspecs size_t _C##_max_capacity(void); \
+_funcspecs void _C##_set_policy(_C##_t *buf, const struct gcl_growth_policy *policy); \
+_funcspecs _T *_C##_reserve(_C##_t *buf, size_t n); \
+_funcspecs _T *_C##_shrink(_C##_t *buf); \
+_funcspecs size_t _C##_cursor(_C##_t *buf); \
+_funcspecs _T *_C##_first_span(_C##_t *buf, size_t *n); \
+_funcspecs _T *_C##_second_span(_C##_t *buf, size_t *n); \
+_funcspecs _C##_pos_t _C##_begin(_C##_t *buf); \
+_funcspecs _C##_pos_t _C##_end(_C##_t *buf); \
+_funcspecs bool _C##_at_begin(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs bool _C##_at_end(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos); \
+_funcspecs void _C##_forward(_C##_pos_t *pos); \
+_funcspecs void _C##_backward(_C##_pos_t *pos); \
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end); \
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range); \
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range); \
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_all(_C##_t *buf); \
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs size_t _C##_range_length(_C##_range_t range); \
+_funcspecs bool _C##_range_empty(_C##_range_t range); \
+_funcspecs _T _C##_front(_C##_t *buf); \
+_funcspecs _T _C##_back(_C##_t *buf); \
+_funcspecs _T _C##_at(_C##_t *buf, size_t i); \
+_funcspecs _T _C##_get(_C##_pos_t pos); \
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos); \
+_funcspecs void _C##_set(_C##_pos_t pos, _T val); \
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *buf, _T val); \
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *buf, _T val); \
+_funcspecs void _C##_remove_front(_C##_t *buf); \
+_funcspecs void _C##_remove_back(_C##_t *buf);
+
+#define GCL_GENERATE_GAP_BUFFER_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+/* Resizes the block to n elements, moving the elements after the gap to its new end. */ \
+_funcspecs _T *_##_C##_do_resize(struct _C *buf, size_t n) \
+{ \
+    assert(n >= _gcl_gap_buffer_length(buf) && n <= _C##_max_capacity()); \
+\
+    size_t capacity = _gcl_gap_buffer_capacity(buf); \
+    size_t cursor = _gcl_gap_buffer_cursor(buf); \
+    size_t after = _gcl_gap_buffer_after(buf); \
+    size_t offset; \
+    _T *data; \
+\
+    if (n < GCL_GAP_BUFFER_MINIMAL_CAPACITY) \
+        n = GCL_GAP_BUFFER_MINIMAL_CAPACITY; \
+\
+    if (n == capacity) \
+        return buf->data; \
+\
+    if (n < capacity) \
+        _##_C##_move_data(buf->gap_end, buf->data_end, buf->data + n - after); \
+\
+    if (!(data = _gcl_realloc(buf->data, capacity * sizeof(_T), n * sizeof(_T)))) { \
+        GCL_ERROR(errno, "Reallocating memory for gap buffer failed"); \
+        if (n < capacity) \
+            _##_C##_move_data(buf->data + n - after, buf->data + n, buf->gap_end); \
+        return NULL; \
+    } \
+\
+    offset = (n < capacity ? n : capacity) - after; \
+\
+    if (buf->policy && buf->policy->round_to_usable_size) \
+        n = _gcl_usable_size(data, n * sizeof(_T)) / sizeof(_T); \
+\
+    if (offset != n - after) \
+        _##_C##_move_data(data + offset, data + offset + after, data + n - after); \
+\
+    _gcl_stats_resize(_C, n, cursor + after); \
+    buf->data = data; \
+    buf->data_end = data + n; \
+    buf->gap_begin = data + cursor; \
+    buf->gap_end = data + n - after; \
+    return data; \
+} \
+\
+_funcspecs _T *_##_C##_grow(struct _C *buf, size_t n) \
+{ \
+    assert(n > _gcl_gap_buffer_length(buf)); \
+\
+    size_t max_cap = _C##_max_capacity(); \
+    size_t new_cap; \
+\
+    _gcl_stats_grow(_C); \
+\
+    if (n > max_cap) \
+        return NULL; \
+\
+    if (buf->policy) \
+        new_cap = gcl_growth_policy_next(buf->policy, _gcl_gap_buffer_capacity(buf), n); \
+    else \
+        new_cap = (size_t) (_gcl_gap_buffer_capacity(buf) * GCL_GAP_BUFFER_GROWTH_FACTOR); \
+\
+    if (new_cap > max_cap) \
+        new_cap = max_cap; \
+\
+    if (new_cap < n) \
+        new_cap = n; \
+\
+    return _##_C##_do_resize(buf, new_cap); \
+} \
+\
+_funcspecs void _##_C##_shrink_by_policy(struct _C *buf) \
+{ \
+    size_t n = gcl_growth_policy_shrink(buf->policy, _gcl_gap_buffer_length(buf), \
+                                        _gcl_gap_buffer_capacity(buf)); \
+\
+    _gcl_stats_capacity(_C, _gcl_gap_buffer_capacity(buf), _gcl_gap_buffer_length(buf)); \
+\
+    if (n) \
+        _##_C##_do_resize(buf, n); \
+} \
+\
+_funcspecs _T *init_##_C(struct _C *buf, size_t n, void (*destroy_elem)(_T)) \
+{ \
+    _T *data; \
+\
+    if (n < GCL_GAP_BUFFER_INITIAL_CAPACITY) \
+        n = GCL_GAP_BUFFER_INITIAL_CAPACITY; \
+\
+    if (!(data = _gcl_malloc(n * sizeof(_T)))) { \
+        GCL_ERROR(errno, "Allocating memory for gap buffer failed"); \
+        return NULL; \
+    } \
+\
+    _gcl_stats_alloc(_C); \
+    _gcl_stats_capacity(_C, n, 0); \
+    *buf = (struct _C) { \
+        .data = data, \
+        .data_end = data + n, \
+        .gap_begin = data, \
+        .gap_end = data + n, \
+        .destroy_elem = destroy_elem, \
+        .policy = NULL \
+    }; \
+    return data; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *buf) \
+{ \
+    _T *ptr; \
+\
+    if (!_##_C##_trivial_elem(buf)) { \
+        _gcl_gap_buffer_for_each_ptr(ptr, buf) \
+            _##_C##_destroy_elem(buf, *ptr); \
+    } \
+\
+    _gcl_stats_free(_C); \
+    _gcl_free(buf->data, _gcl_gap_buffer_capacity(buf) * sizeof(_T)); \
+} \
+\
+_funcspecs void _C##_move_cursor(_C##_t *buf, size_t i) \
+{ \
+    size_t cursor = _gcl_gap_buffer_cursor(buf), n; \
+\
+    assert(i <= _gcl_gap_buffer_length(buf)); \
+\
+    if (i < cursor) { \
+        n = cursor - i; \
+        _##_C##_move_data(buf->data + i, buf->gap_begin, buf->gap_end - n); \
+        buf->gap_begin -= n; \
+        buf->gap_end -= n; \
+    } else if (i > cursor) { \
+        n = i - cursor; \
+        _##_C##_move_data(buf->gap_end, buf->gap_end + n, buf->gap_begin); \
+        buf->gap_begin += n; \
+        buf->gap_end += n; \
+    } \
+} \
+\
+_funcspecs bool _C##_insert_at_cursor(_C##_t *buf, _T val) \
+{ \
+    if (buf->gap_begin == buf->gap_end) { \
+        if (!_##_C##_grow(buf, _gcl_gap_buffer_length(buf) + 1)) { \
+            GCL_ERROR(0, "Increasing gap buffer capacity failed"); \
+            return false; \
+        } \
+    } \
+\
+    *buf->gap_begin++ = val; \
+    _gcl_stats_length(_C, _gcl_gap_buffer_length(buf)); \
+    return true; \
+} \
+\
+_funcspecs bool _C##_insert_array_at_cursor(_C##_t *buf, const _C##_elem_t *src, size_t n) \
+{ \
+    if ((size_t) (buf->gap_end - buf->gap_begin) < n) { \
+        if (!_##_C##_grow(buf, _gcl_gap_buffer_length(buf) + n)) { \
+            GCL_ERROR(0, "Increasing gap buffer capacity failed"); \
+            return false; \
+        } \
+    } \
+\
+    memcpy(buf->gap_begin, src, n * sizeof(_T)); \
+    buf->gap_begin += n; \
+    _gcl_stats_length(_C, _gcl_gap_buffer_length(buf)); \
+    return true; \
+} \
+\
+_funcspecs void _C##_remove_before_cursor(_C##_t *buf) \
+{ \
+    assert(buf->gap_begin > buf->data); \
+\
+    _##_C##_destroy_elem(buf, *--buf->gap_begin); \
+    _##_C##_shrink_by_policy(buf); \
+} \
+\
+_funcspecs void _C##_remove_after_cursor(_C##_t *buf) \
+{ \
+    assert(buf->gap_end < buf->data_end); \
+\
+    _##_C##_destroy_elem(buf, *buf->gap_end++); \
+    _##_C##_shrink_by_policy(buf); \
+} \
+\
+_funcspecs void _C##_remove_range(_C##_t *buf, size_t begin, size_t end) \
+{ \
+    assert(begin <= end && end <= _gcl_gap_buffer_length(buf)); \
+\
+    _C##_move_cursor(buf, begin); \
+\
+    if (!_##_C##_trivial_elem(buf)) { \
+        _T *ptr; \
+        for (ptr = buf->gap_end; ptr != buf->gap_end + (end - begin); ptr++) \
+            _##_C##_destroy_elem(buf, *ptr); \
+    } \
+\
+    buf->gap_end += end - begin; \
+    _##_C##_shrink_by_policy(buf); \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert(_C##_t *buf, _C##_pos_t pos, _T val) \
+{ \
+    assert(_##_C##_valid_pos(buf, pos)); \
+\
+    _C##_move_cursor(buf, pos.i); \
+    if (!_C##_insert_at_cursor(buf, val)) \
+        return _##_C##_pos(NULL, 0); \
+\
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_release(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    assert(_##_C##_valid_pos(buf, pos) && pos.i < _gcl_gap_buffer_length(buf)); \
+\
+    _C##_move_cursor(buf, pos.i); \
+    buf->gap_end++; \
+    _gcl_stats_capacity(_C, _gcl_gap_buffer_capacity(buf), _gcl_gap_buffer_length(buf)); \
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_remove(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    assert(_##_C##_valid_pos(buf, pos) && pos.i < _gcl_gap_buffer_length(buf)); \
+\
+    _C##_move_cursor(buf, pos.i); \
+    _C##_remove_after_cursor(buf); \
+    return pos; \
+} \
+\
+_funcspecs void _C##_release_tail(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    assert(_##_C##_valid_pos(buf, pos)); \
+\
+    _C##_move_cursor(buf, pos.i); \
+    buf->gap_end = buf->data_end; \
+    _gcl_stats_capacity(_C, _gcl_gap_buffer_capacity(buf), _gcl_gap_buffer_length(buf)); \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *buf) \
+{ \
+    _T *ptr; \
+\
+    if (!_##_C##_trivial_elem(buf)) { \
+        _gcl_gap_buffer_for_each_ptr(ptr, buf) \
+            _##_C##_destroy_elem(buf, *ptr); \
+    } \
+\
+    buf->gap_begin = buf->data; \
+    buf->gap_end = buf->data_end; \
+    _gcl_stats_capacity(_C, _gcl_gap_buffer_capacity(buf), 0); \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *buf1, _C##_t *buf2) \
+{ \
+    struct _C tmp = *buf1; \
+    *buf1 = *buf2; \
+    *buf2 = tmp; \
+}
+
+#define GCL_GENERATE_GAP_BUFFER_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs _C##_pos_t _##_C##_pos(struct _C *buf, size_t i) \
+{ \
+    return (struct _C##_pos) { .buf = buf, .i = i }; \
+} \
+\
+_funcspecs bool _##_C##_valid_index(struct _C *buf, size_t i) \
+{ \
+    return i < _gcl_gap_buffer_length(buf); \
+} \
+\
+_funcspecs bool _##_C##_valid_pos(struct _C *buf, struct _C##_pos pos) \
+{ \
+    return pos.buf == buf && pos.i <= _gcl_gap_buffer_length(buf); \
+} \
+\
+_funcspecs _T *_##_C##_ptr_of_index(struct _C *buf, size_t i) \
+{ \
+    size_t cursor = _gcl_gap_buffer_cursor(buf); \
+    return i < cursor ? buf->data + i : buf->gap_end + (i - cursor); \
+} \
+\
+_funcspecs void _##_C##_move_data(_T *begin, _T *end, _T *dest) \
+{ \
+    if (begin < end) { \
+        _gcl_stats_moved(_C, (end - begin) * sizeof(_T)); \
+        memmove(dest, begin, (end - begin) * sizeof(_T)); \
+    } \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *buf) \
+{ \
+    return _gcl_gap_buffer_length(buf); \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *buf) \
+{ \
+    return _gcl_gap_buffer_length(buf) == 0; \
+} \
+\
+_funcspecs size_t _C##_capacity(_C##_t *buf) \
+{ \
+    return _gcl_gap_buffer_capacity(buf); \
+} \
+\
+_funcspecs size_t _C##_max_capacity(void) \
+{ \
+    return (size_t) (SIZE_MAX / (GCL_GAP_BUFFER_GROWTH_FACTOR * sizeof(_T))); \
+} \
+\
+_funcspecs void _C##_set_policy(_C##_t *buf, const struct gcl_growth_policy *policy) \
+{ \
+    buf->policy = policy; \
+} \
+\
+_funcspecs _T *_C##_reserve(_C##_t *buf, size_t n) \
+{ \
+    assert(n <= _C##_max_capacity()); \
+\
+    if (n > _gcl_gap_buffer_capacity(buf)) \
+        return _##_C##_do_resize(buf, n); \
+    else \
+        return buf->data; \
+} \
+\
+_funcspecs _T *_C##_shrink(_C##_t *buf) \
+{ \
+    return _##_C##_do_resize(buf, _gcl_gap_buffer_length(buf)); \
+} \
+\
+_funcspecs size_t _C##_cursor(_C##_t *buf) \
+{ \
+    return _gcl_gap_buffer_cursor(buf); \
+} \
+\
+_funcspecs _T *_C##_first_span(_C##_t *buf, size_t *n) \
+{ \
+    *n = _gcl_gap_buffer_cursor(buf); \
+    return buf->data; \
+} \
+\
+_funcspecs _T *_C##_second_span(_C##_t *buf, size_t *n) \
+{ \
+    *n = _gcl_gap_buffer_after(buf); \
+    return buf->gap_end; \
+} \
+\
+_funcspecs _C##_pos_t _C##_begin(_C##_t *buf) \
+{ \
+    return _##_C##_pos(buf, 0); \
+} \
+\
+_funcspecs _C##_pos_t _C##_end(_C##_t *buf) \
+{ \
+    return _##_C##_pos(buf, _gcl_gap_buffer_length(buf)); \
+} \
+\
+_funcspecs bool _C##_at_begin(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    (void) buf; \
+    return pos.i == 0; \
+} \
+\
+_funcspecs bool _C##_at_end(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    return pos.i == _gcl_gap_buffer_length(buf); \
+} \
+\
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos) \
+{ \
+    pos.i++; \
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos) \
+{ \
+    pos.i--; \
+    return pos; \
+} \
+\
+_funcspecs void _C##_forward(_C##_pos_t *pos) \
+{ \
+    pos->i++; \
+} \
+\
+_funcspecs void _C##_backward(_C##_pos_t *pos) \
+{ \
+    pos->i--; \
+} \
+\
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end) \
+{ \
+    return (struct _C##_range) { begin, end }; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range) \
+{ \
+    return range.begin; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range) \
+{ \
+    return range.end; \
+} \
+\
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.begin.i; \
+} \
+\
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.end.i; \
+} \
+\
+_funcspecs _C##_range_t _C##_all(_C##_t *buf) \
+{ \
+    return (struct _C##_range) { _C##_begin(buf), _C##_end(buf) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { pos, _C##_end(buf) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { _C##_begin(buf), pos }; \
+} \
+\
+_funcspecs size_t _C##_range_length(_C##_range_t range) \
+{ \
+    assert(range.begin.i <= range.end.i); \
+    return range.end.i - range.begin.i; \
+} \
+\
+_funcspecs bool _C##_range_empty(_C##_range_t range) \
+{ \
+    return range.begin.i == range.end.i; \
+} \
+\
+_funcspecs _T _C##_front(_C##_t *buf) \
+{ \
+    assert(!_C##_empty(buf)); \
+    return *_##_C##_ptr_of_index(buf, 0); \
+} \
+\
+_funcspecs _T _C##_back(_C##_t *buf) \
+{ \
+    assert(!_C##_empty(buf)); \
+    return *_##_C##_ptr_of_index(buf, _gcl_gap_buffer_length(buf) - 1); \
+} \
+\
+_funcspecs _T _C##_at(_C##_t *buf, size_t i) \
+{ \
+    assert(_##_C##_valid_index(buf, i)); \
+    return *_##_C##_ptr_of_index(buf, i); \
+} \
+\
+_funcspecs _T _C##_get(_C##_pos_t pos) \
+{ \
+    return _C##_at(pos.buf, pos.i); \
+} \
+\
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos) \
+{ \
+    return _##_C##_ptr_of_index(pos.buf, pos.i); \
+} \
+\
+_funcspecs void _C##_set(_C##_pos_t pos, _T val) \
+{ \
+    assert(_##_C##_valid_index(pos.buf, pos.i)); \
+    *_##_C##_ptr_of_index(pos.buf, pos.i) = val; \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *buf, _T val) \
+{ \
+    return _C##_insert(buf, _C##_begin(buf), val); \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *buf, _T val) \
+{ \
+    return _C##_insert(buf, _C##_end(buf), val); \
+} \
+\
+_funcspecs void _C##_remove_front(_C##_t *buf) \
+{ \
+    assert(!_C##_empty(buf)); \
+    _C##_remove(buf, _C##_begin(buf)); \
+} \
+\
+_funcspecs void _C##_remove_back(_C##_t *buf) \
+{ \
+    assert(!_C##_empty(buf)); \
+    _C##_remove(buf, _C##_prev(_C##_end(buf))); \
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Growth and shrink policies for vectors and ring buffers.
+ *
+ * Containers have a policy member that is NULL after init, in which case
+ * they grow by the compile-time GCL_*_GROWTH_FACTOR and never shrink
+ * automatically.  A policy set with _C##_set_policy must outlive the
+ * container and may be shared between containers.
+ *
+ * Capacity grows by factor_num / factor_den, or by chunk_size once it has
+ * reached chunk_threshold if chunk_size is non-zero.  If either factor is
+ * zero, as in a policy that only sets chunk_size or shrink_divisor, the
+ * factor is 2 / 1.  If next_capacity is set, it replaces both.  If
+ * shrink_divisor is non-zero, _C##_remove shrinks the container once it is
+ * at most 1 / shrink_divisor full, to the capacity it would grow to from its
+ * current length; shrink_divisor should therefore be larger than the growth
+ * factor.  If round_to_usable_size is set, the capacity is extended to cover
+ * the slack the allocator added to the block.
+ */
+
+#ifndef GCL_GROWTH_H
+#define GCL_GROWTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct gcl_growth_policy {
+    unsigned factor_num;
+    unsigned factor_den;
+    size_t chunk_threshold;
+    size_t chunk_size;
+    size_t min_capacity;
+    unsigned shrink_divisor;
+    bool round_to_usable_size;
+    size_t (*next_capacity)(const struct gcl_growth_policy *policy,
+                            size_t capacity, size_t needed);
+};
+
+#define GCL_GROWTH_POLICY_DOUBLE        { 2, 1, 0, 0, 0, 0, false, NULL }
+#define GCL_GROWTH_POLICY_ONE_AND_HALF  { 3, 2, 0, 0, 0, 0, false, NULL }
+
+static inline size_t _gcl_growth_scale(const struct gcl_growth_policy *policy, size_t n)
+{
+    unsigned num = policy->factor_num, den = policy->factor_den;
+
+    if (!num || !den) {
+        num = 2;
+        den = 1;
+    }
+
+    if (n > SIZE_MAX / num)
+        return SIZE_MAX;
+
+    return n * num / den;
+}
+
+static inline size_t gcl_growth_policy_next(const struct gcl_growth_policy *policy,
+                                            size_t capacity, size_t needed)
+{
+    size_t n;
+
+    if (policy->next_capacity)
+        return policy->next_capacity(policy, capacity, needed);
+
+    if (policy->chunk_size && capacity >= policy->chunk_threshold)
+        n = capacity > SIZE_MAX - policy->chunk_size ? SIZE_MAX : capacity + policy->chunk_size;
+    else
+        n = _gcl_growth_scale(policy, capacity);
+
+    if (n < policy->min_capacity)
+        n = policy->min_capacity;
+
+    return n < needed ? needed : n;
+}
+
+/* Returns the capacity to shrink to, or 0 if the container should not shrink. */
+static inline size_t gcl_growth_policy_shrink(const struct gcl_growth_policy *policy,
+                                              size_t length, size_t capacity)
+{
+    size_t n;
+
+    if (!policy || !policy->shrink_divisor || length > capacity / policy->shrink_divisor)
+        return 0;
+
+    n = _gcl_growth_scale(policy, length);
+
+    if (n < policy->min_capacity)
+        n = policy->min_capacity;
+
+    return n < capacity ? n : 0;
+}
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * An intrusive list links objects through a struct gcl_list_link member
+ * embedded in the objects themselves, so inserting and removing never
+ * allocates and an object can be on several lists at once, one link member
+ * per list.  Elements are pointers to the objects; the list does not own
+ * them.  Positions, ranges, splicing and moving work as in list.h.  Links
+ * must be initialized with GCL_LIST_LINK_INIT or gcl_list_link_init before
+ * their object is first inserted and are reset when it is removed.
+ *
+ *     struct conn {
+ *         struct gcl_list_link lru_link;
+ *         struct gcl_list_link timer_link;
+ *     };
+ *
+ *     GCL_GENERATE_INTRUSIVE_LIST_TYPES(lru_list, struct conn, lru_link)
+ *     GCL_GENERATE_INTRUSIVE_LIST_FUNCTIONS_STATIC(lru_list, struct conn, lru_link)
+ */
+
+#ifndef GCL_INTRUSIVE_LIST_H
+#define GCL_INTRUSIVE_LIST_H
+
+#include <stddef.h>
+
+#include "list.h"
+
+#define _gcl_container_of(ptr, _T, member) \
+    ((_T *) ((char *) (ptr) - offsetof(_T, member)))
+
+struct gcl_list_link {
+    struct gcl_list_link *next;
+    struct gcl_list_link *prev;
+};
+
+#define GCL_LIST_LINK_INIT              { NULL, NULL }
+
+static inline void gcl_list_link_init(struct gcl_list_link *link)
+{
+    link->next = NULL;
+    link->prev = NULL;
+}
+
+static inline bool gcl_list_link_linked(const struct gcl_list_link *link)
+{
+    return link->next != NULL;
+}
+
+#define GCL_GENERATE_INTRUSIVE_LIST_TYPES(_C, _T, _link) \
+\
+typedef struct _C _C##_t; \
+typedef struct gcl_list_link _C##_node_t; \
+typedef struct gcl_list_link *_C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef _T *_C##_elem_t; \
+\
+struct _C##_range { \
+    struct gcl_list_link *begin; \
+    struct gcl_list_link *end; \
+}; \
+\
+struct _C { \
+    struct gcl_list_link end; \
+};
+
+#define GCL_GENERATE_INTRUSIVE_LIST_FUNCTIONS_STATIC(_C, _T, _link) \
+    GCL_GENERATE_INTRUSIVE_LIST_LONG_FUNCTION_DECLS(_C, _T, _link, static) \
+    GCL_GENERATE_INTRUSIVE_LIST_SHORT_FUNCTION_DECLS(_C, _T, _link, static inline) \
+    GCL_GENERATE_INTRUSIVE_LIST_LONG_FUNCTION_DEFS(_C, _T, _link, static) \
+    GCL_GENERATE_INTRUSIVE_LIST_SHORT_FUNCTION_DEFS(_C, _T, _link, static inline)
+
+#define GCL_GENERATE_INTRUSIVE_LIST_FUNCTIONS_EXTERN_H(_C, _T, _link) \
+    GCL_GENERATE_INTRUSIVE_LIST_LONG_FUNCTION_DECLS(_C, _T, _link, ) \
+    GCL_GENERATE_INTRUSIVE_LIST_SHORT_FUNCTION_DECLS(_C, _T, _link, inline) \
+    GCL_GENERATE_INTRUSIVE_LIST_SHORT_FUNCTION_DEFS(_C, _T, _link, inline)
+
+#define GCL_GENERATE_INTRUSIVE_LIST_FUNCTIONS_EXTERN_C(_C, _T, _link) \
+    GCL_GENERATE_INTRUSIVE_LIST_LONG_FUNCTION_DEFS(_C, _T, _link, ) \
+    GCL_GENERATE_INTRUSIVE_LIST_SHORT_FUNCTION_DECLS(_C, _T, _link, )
+
+#define GCL_GENERATE_INTRUSIVE_LIST_LONG_FUNCTION_DECLS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs void _C##_clear(_C##_t *list); \
+    GCL_GENERATE_LIST_LINK_LONG_FUNCTION_DECLS(_C, _funcspecs)
+
+#define GCL_GENERATE_INTRUSIVE_LIST_SHORT_FUNCTION_DECLS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs void init_##_C(struct _C *list); \
+_funcspecs _T *_##_C##_entry(struct gcl_list_link *link); \
+_funcspecs _C##_pos_t _C##_pos_of(_T *obj); \
+_funcspecs bool _C##_linked(_T *obj); \
+_funcspecs _T *_C##_front(_C##_t *list); \
+_funcspecs _T *_C##_back(_C##_t *list); \
+_funcspecs _T *_C##_get(_C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_insert(_C##_t *list, _C##_pos_t pos, _T *obj); \
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T *obj); \
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T *obj); \
+_funcspecs _C##_pos_t _C##_remove(_C##_t *list, _C##_pos_t pos); \
+_funcspecs void _C##_remove_elem(_C##_t *list, _T *obj); \
+_funcspecs _T *_C##_remove_front(_C##_t *list); \
+_funcspecs _T *_C##_remove_back(_C##_t *list); \
+    GCL_GENERATE_LIST_LINK_SHORT_FUNCTION_DECLS(_C, _funcspecs)
+
+#define GCL_GENERATE_INTRUSIVE_LIST_LONG_FUNCTION_DEFS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs void _C##_clear(_C##_t *list) \
+{ \
+    struct gcl_list_link *node, *tmp; \
+\
+    _gcl_list_for_each_node_safe(node, tmp, list) \
+        gcl_list_link_init(node); \
+\
+    init_##_C(list); \
+} \
+\
+    GCL_GENERATE_LIST_LINK_LONG_FUNCTION_DEFS(_C, _funcspecs)
+
+#define GCL_GENERATE_INTRUSIVE_LIST_SHORT_FUNCTION_DEFS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs void init_##_C(struct _C *list) \
+{ \
+    list->end.next = &list->end; \
+    list->end.prev = &list->end; \
+} \
+\
+_funcspecs _T *_##_C##_entry(struct gcl_list_link *link) \
+{ \
+    return _gcl_container_of(link, _T, _link); \
+} \
+\
+_funcspecs _C##_pos_t _C##_pos_of(_T *obj) \
+{ \
+    return &obj->_link; \
+} \
+\
+_funcspecs bool _C##_linked(_T *obj) \
+{ \
+    return gcl_list_link_linked(&obj->_link); \
+} \
+\
+_funcspecs _T *_C##_front(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    return _##_C##_entry(_gcl_list_begin(list)); \
+} \
+\
+_funcspecs _T *_C##_back(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    return _##_C##_entry(_gcl_list_end(list)->prev); \
+} \
+\
+_funcspecs _T *_C##_get(_C##_pos_t pos) \
+{ \
+    return _##_C##_entry(pos); \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert(_C##_t *list, _C##_pos_t pos, _T *obj) \
+{ \
+    struct gcl_list_link *node = &obj->_link; \
+\
+    assert(!gcl_list_link_linked(node)); \
+\
+    _C##_link_nodes(pos->prev, node); \
+    _C##_link_nodes(node, pos); \
+    return node; \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T *obj) \
+{ \
+    return _C##_insert(list, _gcl_list_begin(list), obj); \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T *obj) \
+{ \
+    return _C##_insert(list, _gcl_list_end(list), obj); \
+} \
+\
+_funcspecs _C##_pos_t _C##_remove(_C##_t *list, _C##_pos_t pos) \
+{ \
+    assert(pos != _gcl_list_end(list)); \
+\
+    _C##_pos_t next = pos->next; \
+    _C##_unlink_node(pos); \
+    gcl_list_link_init(pos); \
+    return next; \
+} \
+\
+_funcspecs void _C##_remove_elem(_C##_t *list, _T *obj) \
+{ \
+    _C##_remove(list, &obj->_link); \
+} \
+\
+_funcspecs _T *_C##_remove_front(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+\
+    _T *obj = _C##_front(list); \
+    _C##_remove(list, _gcl_list_begin(list)); \
+    return obj; \
+} \
+\
+_funcspecs _T *_C##_remove_back(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+\
+    _T *obj = _C##_back(list); \
+    _C##_remove(list, _gcl_list_end(list)->prev); \
+    return obj; \
+} \
+\
+    GCL_GENERATE_LIST_LINK_SHORT_FUNCTION_DEFS(_C, _funcspecs)
+
+#endif
@@ -5,13 +5,34 @@
  * See the accompanying LICENSE file for details.
  */
 
+/*
+ * Nodes are allocated one at a time, so after a long sequence of insertions
+ * and removals they end up scattered across the heap.  _C##_compact copies
+ * the elements into a single block of nodes in traversal order; nodes that
+ * live in a block are recycled through a free list when released.
+ * _C##_insert_array and _C##_from_range likewise allocate all new nodes in
+ * one block.  Each block counts the nodes that still refer to it and is freed
+ * together with the last of them, so block nodes may be moved or spliced
+ * into another list like any other node.
+ *
+ * To find its block, every node holds a block pointer, which is NULL for
+ * nodes allocated one at a time.  This makes each node one pointer larger
+ * than its links and element, even in lists that never use blocks.  In
+ * exchange, releasing a node takes constant time whichever list it has
+ * been moved to.
+ */
+
 #ifndef GCL_LIST_H
 #define GCL_LIST_H
 
 #include <assert.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include "stats.h"
+#include "traits.h"
+
 #ifndef GCL_ERROR
 #define GCL_ERROR(errnum, ...)
 #endif
@@ -32,6 +53,7 @@
 #define GCL_GENERATE_LIST_TYPES(_C, _T) \
 \
 typedef struct _C _C##_t; \
+typedef struct _C##_node _C##_node_t; \
 typedef struct _C##_node *_C##_pos_t; \
 typedef struct _C##_range _C##_range_t; \
 typedef _T _C##_elem_t; \
@@ -39,6 +61,7 @@ typedef _T _C##_elem_t; \
 struct _C##_node { \
     struct _C##_node *next; \
     struct _C##_node *prev; \
+    struct _C##_block *block; \
     _T elem; \
 }; \
 \
@@ -47,41 +70,101 @@ struct _C##_range { \
     struct _C##_node *end; \
 }; \
 \
+struct _C##_block { \
+    size_t n; \
+    size_t live; \
+    struct _C##_node nodes[]; \
+}; \
+\
 struct _C { \
     struct _C##_node end; \
     void (*destroy_elem)(_T); \
+    struct _C##_node *free_nodes; \
 };
 
 #define GCL_GENERATE_LIST_FUNCTIONS_STATIC(_C, _T) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, static inline) \
     GCL_GENERATE_LIST_LONG_FUNCTION_DECLS(_C, _T, static) \
     GCL_GENERATE_LIST_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
     GCL_GENERATE_LIST_LONG_FUNCTION_DEFS(_C, _T, static) \
     GCL_GENERATE_LIST_SHORT_FUNCTION_DEFS(_C, _T, static inline)
 
 #define GCL_GENERATE_LIST_FUNCTIONS_EXTERN_H(_C, _T) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, inline) \
     GCL_GENERATE_LIST_LONG_FUNCTION_DECLS(_C, _T, ) \
     GCL_GENERATE_LIST_SHORT_FUNCTION_DECLS(_C, _T, inline) \
     GCL_GENERATE_LIST_SHORT_FUNCTION_DEFS(_C, _T, inline)
 
 #define GCL_GENERATE_LIST_FUNCTIONS_EXTERN_C(_C, _T) \
+    _gcl_stats_define_extern(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, ) \
     GCL_GENERATE_LIST_LONG_FUNCTION_DEFS(_C, _T, ) \
     GCL_GENERATE_LIST_SHORT_FUNCTION_DECLS(_C, _T, )
 
+#define GCL_GENERATE_LIST_FUNCTIONS_STATIC_EX(_C, _T, traits) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, static inline) \
+    GCL_GENERATE_LIST_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_LIST_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_LIST_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_LIST_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_LIST_FUNCTIONS_EXTERN_H_EX(_C, _T, traits) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, inline) \
+    GCL_GENERATE_LIST_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_LIST_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_LIST_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_LIST_FUNCTIONS_EXTERN_C_EX(_C, _T, traits) \
+    GCL_GENERATE_LIST_FUNCTIONS_EXTERN_C(_C, _T)
+
 #define GCL_GENERATE_LIST_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
 \
+_funcspecs void _##_C##_free_node(struct _C##_node *node); \
+_funcspecs void _##_C##_free_free_nodes(struct _C *list); \
+_funcspecs struct _C##_block *_##_C##_new_block(size_t n); \
+_funcspecs void _##_C##_link_block(struct _C##_node *prev, struct _C##_block *block, struct _C##_node *next); \
 _funcspecs void destroy_##_C(struct _C *list); \
 _funcspecs _C##_pos_t _C##_insert(_C##_t *list, _C##_pos_t pos, _T val); \
 _funcspecs _C##_pos_t _C##_release(_C##_t *list, _C##_pos_t pos); \
 _funcspecs _C##_pos_t _C##_remove(_C##_t *list, _C##_pos_t pos); \
 _funcspecs void _C##_clear(_C##_t *list); \
+_funcspecs _C##_pos_t _C##_insert_array(_C##_t *list, _C##_pos_t pos, const _C##_elem_t *src, size_t n); \
+_funcspecs _C##_pos_t _C##_from_range(_C##_t *list, _C##_pos_t pos, _C##_range_t range); \
+_funcspecs bool _C##_compact(_C##_t *list); \
+    GCL_GENERATE_LIST_LINK_LONG_FUNCTION_DECLS(_C, _funcspecs)
+
+#define GCL_GENERATE_LIST_LINK_LONG_FUNCTION_DECLS(_C, _funcspecs) \
+\
 _funcspecs void _C##_move(_C##_t *dest_list, _C##_pos_t dest_pos, _C##_t *src_list, _C##_pos_t src_pos); \
-_funcspecs void _C##_splice(_C##_t *dest_list, _C##_pos_t pos, _C##_t *src_list, _C##_range_t range);
+_funcspecs void _C##_splice(_C##_t *dest_list, _C##_pos_t pos, _C##_t *src_list, _C##_range_t range); \
+_funcspecs void _C##_swap(_C##_t *list1, _C##_t *list2);
 
 #define GCL_GENERATE_LIST_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
 \
 _funcspecs void init_##_C(struct _C *list, void (*destroy_elem)(_T)); \
-_funcspecs void _C##_link_nodes(struct _C##_node *prev, struct _C##_node *next); \
-_funcspecs void _C##_unlink_node(struct _C##_node* node); \
+_funcspecs _T _C##_front(_C##_t *list); \
+_funcspecs _T _C##_back(_C##_t *list); \
+_funcspecs _T _C##_get(_C##_pos_t pos); \
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos); \
+_funcspecs void _C##_set(_C##_pos_t pos, _T val); \
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T val); \
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T val); \
+_funcspecs void _C##_remove_front(_C##_t *list); \
+_funcspecs void _C##_remove_back(_C##_t *list); \
+    GCL_GENERATE_LIST_LINK_SHORT_FUNCTION_DECLS(_C, _funcspecs)
+
+#define GCL_GENERATE_LIST_LINK_SHORT_FUNCTION_DECLS(_C, _funcspecs) \
+\
+_funcspecs void _C##_link_nodes(_C##_node_t *prev, _C##_node_t *next); \
+_funcspecs void _C##_unlink_node(_C##_node_t *node); \
 _funcspecs bool _C##_empty(_C##_t *list); \
 _funcspecs _C##_pos_t _C##_begin(_C##_t *list); \
 _funcspecs _C##_pos_t _C##_end(_C##_t *list); \
@@ -100,15 +183,6 @@ _funcspecs _C##_range_t _C##_all(_C##_t *list); \
 _funcspecs _C##_range_t _C##_range_from_pos(_C##_t *list, _C##_pos_t pos); \
 _funcspecs _C##_range_t _C##_range_to_pos(_C##_t *list, _C##_pos_t pos); \
 _funcspecs bool _C##_range_empty(_C##_range_t range); \
-_funcspecs _T _C##_front(_C##_t *list); \
-_funcspecs _T _C##_back(_C##_t *list); \
-_funcspecs _T _C##_get(_C##_pos_t pos); \
-_funcspecs _T *_C##_get_ptr(_C##_pos_t pos); \
-_funcspecs void _C##_set(_C##_pos_t pos, _T val); \
-_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T val); \
-_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T val); \
-_funcspecs void _C##_remove_front(_C##_t *list); \
-_funcspecs void _C##_remove_back(_C##_t *list); \
 _funcspecs void _C##_move_front(_C##_t *dest_list, _C##_t *src_list, _C##_pos_t pos); \
 _funcspecs void _C##_move_back(_C##_t *dest_list, _C##_t *src_list, _C##_pos_t pos); \
 _funcspecs void _C##_splice_front(_C##_t *dest_list, _C##_t *src_list, _C##_range_t range); \
@@ -120,30 +194,93 @@ _funcspecs void init_##_C(struct _C *list, void (*destroy_elem)(_T)) \
 { \
     *list = (struct _C) { \
         .end = { .next = &list->end, .prev = &list->end }, \
-        .destroy_elem = destroy_elem \
+        .destroy_elem = destroy_elem, \
+        .free_nodes = NULL \
     }; \
 } \
 \
+_funcspecs void _##_C##_free_node(struct _C##_node *node) \
+{ \
+    struct _C##_block *block = node->block; \
+\
+    if (!block) { \
+        _gcl_stats_free(_C); \
+        free(node); \
+    } else if (--block->live == 0) { \
+        _gcl_stats_free(_C); \
+        free(block); \
+    } \
+} \
+\
+_funcspecs void _##_C##_free_free_nodes(struct _C *list) \
+{ \
+    struct _C##_node *node, *tmp; \
+\
+    for (node = list->free_nodes; node; node = tmp) { \
+        tmp = node->next; \
+        _##_C##_free_node(node); \
+    } \
+\
+    list->free_nodes = NULL; \
+} \
+\
+_funcspecs struct _C##_block *_##_C##_new_block(size_t n) \
+{ \
+    struct _C##_block *block; \
+    size_t i; \
+\
+    if (!(block = malloc(sizeof(*block) + n * sizeof(struct _C##_node)))) { \
+        GCL_ERROR(errno, "Allocating memory for list block failed"); \
+        return NULL; \
+    } \
+\
+    _gcl_stats_alloc(_C); \
+    block->n = n; \
+    block->live = n; \
+    for (i = 0; i < n; i++) \
+        block->nodes[i].block = block; \
+    return block; \
+} \
+\
+_funcspecs void _##_C##_link_block(struct _C##_node *prev, struct _C##_block *block, struct _C##_node *next) \
+{ \
+    size_t i; \
+\
+    _C##_link_nodes(prev, &block->nodes[0]); \
+    for (i = 1; i < block->n; i++) \
+        _C##_link_nodes(&block->nodes[i - 1], &block->nodes[i]); \
+    _C##_link_nodes(&block->nodes[block->n - 1], next); \
+} \
+\
 _funcspecs void destroy_##_C(struct _C *list) \
 { \
     struct _C##_node *node, *tmp; \
 \
-    if (list->destroy_elem) { \
+    if (!_##_C##_trivial_elem(list)) { \
         _gcl_list_for_each_node(node, list) \
-            list->destroy_elem(node->elem); \
+            _##_C##_destroy_elem(list, node->elem); \
     } \
 \
     _gcl_list_for_each_node_safe(node, tmp, list) \
-        free(node); \
+        _##_C##_free_node(node); \
+\
+    _##_C##_free_free_nodes(list); \
 } \
 \
 _funcspecs _C##_pos_t _C##_insert(_C##_t *list, _C##_pos_t pos, _T val) \
 { \
     struct _C##_node *node; \
 \
-    if (!(node = malloc(sizeof(*node)))) { \
-        GCL_ERROR(errno, "Allocating memory for list node failed"); \
-        return NULL; \
+    if (list->free_nodes) { \
+        node = list->free_nodes; \
+        list->free_nodes = node->next; \
+    } else { \
+        if (!(node = malloc(sizeof(*node)))) { \
+            GCL_ERROR(errno, "Allocating memory for list node failed"); \
+            return NULL; \
+        } \
+        _gcl_stats_alloc(_C); \
+        node->block = NULL; \
     } \
 \
     node->elem = val; \
@@ -158,7 +295,14 @@ _funcspecs _C##_pos_t _C##_release(_C##_t *list, _C##_pos_t pos) \
 \
     _C##_pos_t next = pos->next; \
     _C##_unlink_node(pos); \
-    free(pos); \
+\
+    if (pos->block) { \
+        pos->next = list->free_nodes; \
+        list->free_nodes = pos; \
+    } else { \
+        _##_C##_free_node(pos); \
+    } \
+\
     return next; \
 } \
 \
@@ -166,26 +310,89 @@ _funcspecs _C##_pos_t _C##_remove(_C##_t *list, _C##_pos_t pos) \
 { \
     assert(pos != _gcl_list_end(list)); \
 \
-    if (list->destroy_elem) \
-        list->destroy_elem(pos->elem); \
+    _##_C##_destroy_elem(list, pos->elem); \
 \
     return _C##_release(list, pos); \
 } \
 \
 _funcspecs void _C##_clear(_C##_t *list) \
 { \
+    destroy_##_C(list); \
+    init_##_C(list, list->destroy_elem); \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_array(_C##_t *list, _C##_pos_t pos, const _C##_elem_t *src, size_t n) \
+{ \
+    struct _C##_block *block; \
+    size_t i; \
+\
+    if (n == 0) \
+        return pos; \
+\
+    if (!(block = _##_C##_new_block(n))) \
+        return NULL; \
+\
+    for (i = 0; i < n; i++) \
+        block->nodes[i].elem = src[i]; \
+\
+    _##_C##_link_block(pos->prev, block, pos); \
+    return &block->nodes[0]; \
+} \
+\
+_funcspecs _C##_pos_t _C##_from_range(_C##_t *list, _C##_pos_t pos, _C##_range_t range) \
+{ \
+    struct _C##_block *block; \
+    struct _C##_node *node; \
+    size_t n = 0; \
+\
+    for (node = range.begin; node != range.end; node = node->next) \
+        n++; \
+\
+    if (n == 0) \
+        return pos; \
+\
+    if (!(block = _##_C##_new_block(n))) \
+        return NULL; \
+\
+    for (node = range.begin, n = 0; node != range.end; node = node->next) \
+        block->nodes[n++].elem = node->elem; \
+\
+    _##_C##_link_block(pos->prev, block, pos); \
+    return &block->nodes[0]; \
+} \
+\
+_funcspecs bool _C##_compact(_C##_t *list) \
+{ \
+    struct _C##_block *block; \
     struct _C##_node *node, *tmp; \
+    size_t n = 0; \
 \
-    if (list->destroy_elem) { \
-        _gcl_list_for_each_node(node, list) \
-            list->destroy_elem(node->elem); \
+    _gcl_list_for_each_node(node, list) \
+        n++; \
+\
+    if (n == 0) { \
+        _##_C##_free_free_nodes(list); \
+        return true; \
     } \
 \
-    _gcl_list_for_each_node_safe(node, tmp, list) \
-        free(node); \
+    if (!(block = _##_C##_new_block(n))) \
+        return false; \
 \
-    init_##_C(list, list->destroy_elem); \
+    n = 0; \
+\
+    _gcl_list_for_each_node_safe(node, tmp, list) { \
+        block->nodes[n++].elem = node->elem; \
+        _##_C##_free_node(node); \
+    } \
+\
+    _##_C##_free_free_nodes(list); \
+    _##_C##_link_block(_gcl_list_end(list), block, _gcl_list_end(list)); \
+    return true; \
 } \
+\
+    GCL_GENERATE_LIST_LINK_LONG_FUNCTION_DEFS(_C, _funcspecs)
+
+#define GCL_GENERATE_LIST_LINK_LONG_FUNCTION_DEFS(_C, _funcspecs) \
 \
 _funcspecs void _C##_move(_C##_t *dest_list, _C##_pos_t dest_pos, _C##_t *src_list, _C##_pos_t src_pos) \
 { \
@@ -198,20 +405,97 @@ _funcspecs void _C##_move(_C##_t *dest_list, _C##_pos_t dest_pos, _C##_t *src_li
 \
 _funcspecs void _C##_splice(_C##_t *dest_list, _C##_pos_t pos, _C##_t *src_list, _C##_range_t range) \
 { \
-    _C##_link_nodes(range.end->prev, pos); \
+    if (range.begin == range.end) \
+        return; \
+\
+    _C##_node_t *last = range.end->prev; \
     _C##_link_nodes(range.begin->prev, range.end); \
     _C##_link_nodes(pos->prev, range.begin); \
+    _C##_link_nodes(last, pos); \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *list1, _C##_t *list2) \
+{ \
+    struct _C tmp = *list1; \
+    *list1 = *list2; \
+    *list2 = tmp; \
+\
+    if (_gcl_list_begin(list1) == _gcl_list_end(list2)) { \
+        _C##_link_nodes(_gcl_list_end(list1), _gcl_list_end(list1)); \
+    } else { \
+        _C##_link_nodes(_gcl_list_end(list1), list1->end.next); \
+        _C##_link_nodes(list1->end.prev, _gcl_list_end(list1)); \
+    } \
+\
+    if (_gcl_list_begin(list2) == _gcl_list_end(list1)) { \
+        _C##_link_nodes(_gcl_list_end(list2), _gcl_list_end(list2)); \
+    } else { \
+        _C##_link_nodes(_gcl_list_end(list2), list2->end.next); \
+        _C##_link_nodes(list2->end.prev, _gcl_list_end(list2)); \
+    } \
 }
 
 #define GCL_GENERATE_LIST_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
 \
-_funcspecs void _C##_link_nodes(struct _C##_node *prev, struct _C##_node *next) \
+_funcspecs _T _C##_front(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    return _gcl_list_begin(list)->elem; \
+} \
+\
+_funcspecs _T _C##_back(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    return _gcl_list_end(list)->prev->elem; \
+} \
+\
+_funcspecs _T _C##_get(_C##_pos_t pos) \
+{ \
+    return pos->elem; \
+} \
+\
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos) \
+{ \
+    return &pos->elem; \
+} \
+\
+_funcspecs void _C##_set(_C##_pos_t pos, _T val) \
+{ \
+    pos->elem = val; \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T val) \
+{ \
+    return _C##_insert(list, _gcl_list_begin(list), val); \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T val) \
+{ \
+    return _C##_insert(list, _gcl_list_end(list), val); \
+} \
+\
+_funcspecs void _C##_remove_front(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    _C##_remove(list, _gcl_list_begin(list)); \
+} \
+\
+_funcspecs void _C##_remove_back(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    _C##_remove(list, _gcl_list_end(list)->prev); \
+} \
+    GCL_GENERATE_LIST_LINK_SHORT_FUNCTION_DEFS(_C, _funcspecs)
+
+#define GCL_GENERATE_LIST_LINK_SHORT_FUNCTION_DEFS(_C, _funcspecs) \
+\
+_funcspecs void _C##_link_nodes(_C##_node_t *prev, _C##_node_t *next) \
 { \
     prev->next = next; \
     next->prev = prev; \
 } \
 \
-_funcspecs void _C##_unlink_node(struct _C##_node* node) \
+_funcspecs void _C##_unlink_node(_C##_node_t *node) \
 { \
     _C##_link_nodes(node->prev, node->next); \
 } \
@@ -306,55 +590,6 @@ _funcspecs bool _C##_range_empty(_C##_range_t range) \
     return range.begin == range.end; \
 } \
 \
-_funcspecs _T _C##_front(_C##_t *list) \
-{ \
-    assert(!_C##_empty(list)); \
-    return _gcl_list_begin(list)->elem; \
-} \
-\
-_funcspecs _T _C##_back(_C##_t *list) \
-{ \
-    assert(!_C##_empty(list)); \
-    return _gcl_list_end(list)->prev->elem; \
-} \
-\
-_funcspecs _T _C##_get(_C##_pos_t pos) \
-{ \
-    return pos->elem; \
-} \
-\
-_funcspecs _T *_C##_get_ptr(_C##_pos_t pos) \
-{ \
-    return &pos->elem; \
-} \
-\
-_funcspecs void _C##_set(_C##_pos_t pos, _T val) \
-{ \
-    pos->elem = val; \
-} \
-\
-_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T val) \
-{ \
-    return _C##_insert(list, _gcl_list_begin(list), val); \
-} \
-\
-_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T val) \
-{ \
-    return _C##_insert(list, _gcl_list_end(list), val); \
-} \
-\
-_funcspecs void _C##_remove_front(_C##_t *list) \
-{ \
-    assert(!_C##_empty(list)); \
-    _C##_remove(list, _gcl_list_begin(list)); \
-} \
-\
-_funcspecs void _C##_remove_back(_C##_t *list) \
-{ \
-    assert(!_C##_empty(list)); \
-    _C##_remove(list, _gcl_list_end(list)->prev); \
-} \
-\
 _funcspecs void _C##_move_front(_C##_t *dest_list, _C##_t *src_list, _C##_pos_t pos) \
 { \
     assert(pos != _gcl_list_end(src_list)); \
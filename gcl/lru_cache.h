@@ -0,0 +1,409 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A fixed-capacity cache that maps keys to values and evicts the least
+ * recently used entry when it is full.  The entries live in a pool of
+ * nodes allocated once by init_##_C, linked into a recency list through
+ * 32-bit node indices, and are found through an open-addressing index with
+ * linear probing that is kept at most half full.  A hit therefore costs one
+ * probe sequence and, in LRU mode, relinking the node to the front of the
+ * recency list; nothing is ever allocated after init_##_C.
+ *
+ * In CLOCK mode, a hit only sets the node's referenced flag, and eviction
+ * sweeps a hand over the pool, clearing referenced flags, until it finds an
+ * entry that has not been referenced since the hand last passed it.
+ *
+ * The _hash and _eq arguments of the function generators are functions or
+ * function-like macros, for instance those of a traits set from traits.h.
+ * _hash returns a size_t; the cache mixes it, so it need not be uniform in
+ * its low bits.  If an eviction callback is set with _C##_set_evict, it is
+ * called for every entry that the cache drops: on eviction, removal,
+ * replacement by _C##_put, clear and destroy.
+ *
+ *     GCL_GENERATE_LRU_CACHE_TYPES(sess_cache, uint64_t, struct session *)
+ *     GCL_GENERATE_LRU_CACHE_FUNCTIONS_STATIC(sess_cache, uint64_t, struct session *,
+ *                                             gcl_scalar_traits_hash, gcl_scalar_traits_eq)
+ */
+
+#ifndef GCL_LRU_CACHE_H
+#define GCL_LRU_CACHE_H
+
+#ifndef GCL_ERROR
+#define GCL_ERROR(errnum, ...)
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+
+#define GCL_LRU_CACHE_NO_NODE           UINT32_MAX
+#define GCL_LRU_CACHE_MAX_CAPACITY      (UINT32_MAX / 2 - 1)
+
+enum gcl_cache_policy {
+    GCL_CACHE_LRU,
+    GCL_CACHE_CLOCK
+};
+
+struct gcl_cache_index_entry {
+    uint32_t hash;
+    uint32_t node;
+};
+
+static inline uint32_t _gcl_cache_mix(size_t hash)
+{
+    return (uint32_t) (((uint64_t) hash * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+#define GCL_GENERATE_LRU_CACHE_TYPES(_C, _K, _V) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_node _C##_node_t; \
+typedef _K _C##_key_t; \
+typedef _V _C##_value_t; \
+\
+struct _C##_node { \
+    _K key; \
+    _V val; \
+    uint32_t prev; \
+    uint32_t next; \
+    uint32_t index; \
+    bool referenced; \
+}; \
+\
+struct _C { \
+    struct _C##_node *nodes; \
+    struct gcl_cache_index_entry *index; \
+    uint32_t capacity; \
+    uint32_t length; \
+    uint32_t used; \
+    uint32_t free_head; \
+    uint32_t hand; \
+    uint32_t index_mask; \
+    enum gcl_cache_policy policy; \
+    void (*evict)(_K, _V, void *); \
+    void *evict_arg; \
+    uint64_t hits; \
+    uint64_t misses; \
+    uint64_t evictions; \
+};
+
+#define GCL_GENERATE_LRU_CACHE_FUNCTIONS_STATIC(_C, _K, _V, _hash, _eq) \
+    GCL_GENERATE_LRU_CACHE_LONG_FUNCTION_DECLS(_C, _K, _V, static) \
+    GCL_GENERATE_LRU_CACHE_SHORT_FUNCTION_DECLS(_C, _K, _V, static inline) \
+    GCL_GENERATE_LRU_CACHE_LONG_FUNCTION_DEFS(_C, _K, _V, _hash, _eq, static) \
+    GCL_GENERATE_LRU_CACHE_SHORT_FUNCTION_DEFS(_C, _K, _V, static inline)
+
+#define GCL_GENERATE_LRU_CACHE_FUNCTIONS_EXTERN_H(_C, _K, _V, _hash, _eq) \
+    GCL_GENERATE_LRU_CACHE_LONG_FUNCTION_DECLS(_C, _K, _V, ) \
+    GCL_GENERATE_LRU_CACHE_SHORT_FUNCTION_DECLS(_C, _K, _V, inline) \
+    GCL_GENERATE_LRU_CACHE_SHORT_FUNCTION_DEFS(_C, _K, _V, inline)
+
+#define GCL_GENERATE_LRU_CACHE_FUNCTIONS_EXTERN_C(_C, _K, _V, _hash, _eq) \
+    GCL_GENERATE_LRU_CACHE_LONG_FUNCTION_DEFS(_C, _K, _V, _hash, _eq, ) \
+    GCL_GENERATE_LRU_CACHE_SHORT_FUNCTION_DECLS(_C, _K, _V, )
+
+#define GCL_GENERATE_LRU_CACHE_LONG_FUNCTION_DECLS(_C, _K, _V, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *cache, size_t capacity, enum gcl_cache_policy policy); \
+_funcspecs void destroy_##_C(struct _C *cache); \
+_funcspecs uint32_t _##_C##_find(struct _C *cache, _K key, uint32_t hash); \
+_funcspecs void _##_C##_unindex(struct _C *cache, uint32_t i); \
+_funcspecs uint32_t _##_C##_evict_node(struct _C *cache); \
+_funcspecs _V *_C##_get(_C##_t *cache, _K key); \
+_funcspecs _V *_C##_peek(_C##_t *cache, _K key); \
+_funcspecs _V *_C##_put(_C##_t *cache, _K key, _V val); \
+_funcspecs bool _C##_remove(_C##_t *cache, _K key); \
+_funcspecs void _C##_clear(_C##_t *cache);
+
+#define GCL_GENERATE_LRU_CACHE_SHORT_FUNCTION_DECLS(_C, _K, _V, _funcspecs) \
+\
+_funcspecs void _##_C##_unlink(struct _C *cache, uint32_t n); \
+_funcspecs void _##_C##_link_front(struct _C *cache, uint32_t n); \
+_funcspecs void _##_C##_touch(struct _C *cache, uint32_t n); \
+_funcspecs void _##_C##_drop(struct _C *cache, uint32_t n); \
+_funcspecs size_t _C##_length(_C##_t *cache); \
+_funcspecs bool _C##_empty(_C##_t *cache); \
+_funcspecs size_t _C##_capacity(_C##_t *cache); \
+_funcspecs void _C##_set_evict(_C##_t *cache, void (*evict)(_K, _V, void *), void *arg); \
+_funcspecs void _C##_reset_counters(_C##_t *cache);
+
+#define GCL_GENERATE_LRU_CACHE_LONG_FUNCTION_DEFS(_C, _K, _V, _hash, _eq, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *cache, size_t capacity, enum gcl_cache_policy policy) \
+{ \
+    size_t index_size = 2; \
+\
+    assert(capacity > 0 && capacity <= GCL_LRU_CACHE_MAX_CAPACITY); \
+\
+    while (index_size < 2 * capacity) \
+        index_size *= 2; \
+\
+    if (!(cache->nodes = _gcl_malloc((capacity + 1) * sizeof(struct _C##_node)))) { \
+        GCL_ERROR(errno, "Allocating memory for cache nodes failed"); \
+        return false; \
+    } \
+\
+    if (!(cache->index = _gcl_malloc(index_size * sizeof(struct gcl_cache_index_entry)))) { \
+        GCL_ERROR(errno, "Allocating memory for cache index failed"); \
+        _gcl_free(cache->nodes, (capacity + 1) * sizeof(struct _C##_node)); \
+        return false; \
+    } \
+\
+    memset(cache->index, 0xff, index_size * sizeof(struct gcl_cache_index_entry)); \
+    cache->capacity = (uint32_t) capacity; \
+    cache->length = 0; \
+    cache->used = 0; \
+    cache->free_head = GCL_LRU_CACHE_NO_NODE; \
+    cache->hand = 0; \
+    cache->index_mask = (uint32_t) (index_size - 1); \
+    cache->policy = policy; \
+    cache->evict = NULL; \
+    cache->evict_arg = NULL; \
+    cache->nodes[capacity].prev = (uint32_t) capacity; \
+    cache->nodes[capacity].next = (uint32_t) capacity; \
+    _C##_reset_counters(cache); \
+    return true; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *cache) \
+{ \
+    _C##_clear(cache); \
+    _gcl_free(cache->nodes, (cache->capacity + 1) * sizeof(struct _C##_node)); \
+    _gcl_free(cache->index, \
+              ((size_t) cache->index_mask + 1) * sizeof(struct gcl_cache_index_entry)); \
+} \
+\
+_funcspecs uint32_t _##_C##_find(struct _C *cache, _K key, uint32_t h) \
+{ \
+    uint32_t i = h & cache->index_mask, n; \
+\
+    while ((n = cache->index[i].node) != GCL_LRU_CACHE_NO_NODE) { \
+        if (cache->index[i].hash == h && _eq(cache->nodes[n].key, key)) \
+            return i; \
+        i = (i + 1) & cache->index_mask; \
+    } \
+\
+    return GCL_LRU_CACHE_NO_NODE; \
+} \
+\
+_funcspecs void _##_C##_unindex(struct _C *cache, uint32_t i) \
+{ \
+    uint32_t j = i, home; \
+\
+    for (;;) { \
+        j = (j + 1) & cache->index_mask; \
+        if (cache->index[j].node == GCL_LRU_CACHE_NO_NODE) \
+            break; \
+        home = cache->index[j].hash & cache->index_mask; \
+        if (((j - home) & cache->index_mask) >= ((j - i) & cache->index_mask)) { \
+            cache->index[i] = cache->index[j]; \
+            cache->nodes[cache->index[i].node].index = i; \
+            i = j; \
+        } \
+    } \
+\
+    cache->index[i].node = GCL_LRU_CACHE_NO_NODE; \
+} \
+\
+_funcspecs uint32_t _##_C##_evict_node(struct _C *cache) \
+{ \
+    uint32_t n; \
+\
+    if (cache->policy == GCL_CACHE_CLOCK) { \
+        while (cache->nodes[cache->hand].referenced) { \
+            cache->nodes[cache->hand].referenced = false; \
+            cache->hand = cache->hand + 1 < cache->capacity ? cache->hand + 1 : 0; \
+        } \
+        n = cache->hand; \
+        cache->hand = cache->hand + 1 < cache->capacity ? cache->hand + 1 : 0; \
+    } else { \
+        n = cache->nodes[cache->capacity].prev; \
+    } \
+\
+    cache->evictions++; \
+    _##_C##_drop(cache, n); \
+    return n; \
+} \
+\
+_funcspecs _V *_C##_get(_C##_t *cache, _K key) \
+{ \
+    uint32_t i = _##_C##_find(cache, key, _gcl_cache_mix(_hash(key))); \
+\
+    if (i == GCL_LRU_CACHE_NO_NODE) { \
+        cache->misses++; \
+        return NULL; \
+    } \
+\
+    cache->hits++; \
+    _##_C##_touch(cache, cache->index[i].node); \
+    return &cache->nodes[cache->index[i].node].val; \
+} \
+\
+_funcspecs _V *_C##_peek(_C##_t *cache, _K key) \
+{ \
+    uint32_t i = _##_C##_find(cache, key, _gcl_cache_mix(_hash(key))); \
+\
+    if (i == GCL_LRU_CACHE_NO_NODE) \
+        return NULL; \
+\
+    return &cache->nodes[cache->index[i].node].val; \
+} \
+\
+_funcspecs _V *_C##_put(_C##_t *cache, _K key, _V val) \
+{ \
+    uint32_t h = _gcl_cache_mix(_hash(key)); \
+    uint32_t i = _##_C##_find(cache, key, h), n; \
+    struct _C##_node *node; \
+\
+    if (i != GCL_LRU_CACHE_NO_NODE) { \
+        node = &cache->nodes[cache->index[i].node]; \
+        if (cache->evict) \
+            cache->evict(node->key, node->val, cache->evict_arg); \
+        node->key = key; \
+        node->val = val; \
+        _##_C##_touch(cache, cache->index[i].node); \
+        return &node->val; \
+    } \
+\
+    if (cache->free_head != GCL_LRU_CACHE_NO_NODE) { \
+        n = cache->free_head; \
+        cache->free_head = cache->nodes[n].next; \
+    } else if (cache->used < cache->capacity) { \
+        n = cache->used++; \
+    } else { \
+        n = _##_C##_evict_node(cache); \
+        cache->free_head = cache->nodes[n].next; \
+    } \
+\
+    i = h & cache->index_mask; \
+    while (cache->index[i].node != GCL_LRU_CACHE_NO_NODE) \
+        i = (i + 1) & cache->index_mask; \
+\
+    cache->index[i].hash = h; \
+    cache->index[i].node = n; \
+    node = &cache->nodes[n]; \
+    node->key = key; \
+    node->val = val; \
+    node->index = i; \
+    node->referenced = false; \
+    if (cache->policy == GCL_CACHE_LRU) \
+        _##_C##_link_front(cache, n); \
+    cache->length++; \
+    return &node->val; \
+} \
+\
+_funcspecs bool _C##_remove(_C##_t *cache, _K key) \
+{ \
+    uint32_t i = _##_C##_find(cache, key, _gcl_cache_mix(_hash(key))); \
+\
+    if (i == GCL_LRU_CACHE_NO_NODE) \
+        return false; \
+\
+    _##_C##_drop(cache, cache->index[i].node); \
+    return true; \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *cache) \
+{ \
+    size_t i; \
+\
+    for (i = 0; i < (size_t) cache->index_mask + 1; i++) { \
+        if (cache->index[i].node != GCL_LRU_CACHE_NO_NODE && cache->evict) { \
+            struct _C##_node *node = &cache->nodes[cache->index[i].node]; \
+            cache->evict(node->key, node->val, cache->evict_arg); \
+        } \
+        cache->index[i].node = GCL_LRU_CACHE_NO_NODE; \
+    } \
+\
+    cache->length = 0; \
+    cache->used = 0; \
+    cache->free_head = GCL_LRU_CACHE_NO_NODE; \
+    cache->hand = 0; \
+    cache->nodes[cache->capacity].prev = cache->capacity; \
+    cache->nodes[cache->capacity].next = cache->capacity; \
+}
+
+#define GCL_GENERATE_LRU_CACHE_SHORT_FUNCTION_DEFS(_C, _K, _V, _funcspecs) \
+\
+_funcspecs void _##_C##_unlink(struct _C *cache, uint32_t n) \
+{ \
+    struct _C##_node *node = &cache->nodes[n]; \
+\
+    cache->nodes[node->prev].next = node->next; \
+    cache->nodes[node->next].prev = node->prev; \
+} \
+\
+_funcspecs void _##_C##_link_front(struct _C *cache, uint32_t n) \
+{ \
+    struct _C##_node *head = &cache->nodes[cache->capacity]; \
+\
+    cache->nodes[n].prev = cache->capacity; \
+    cache->nodes[n].next = head->next; \
+    cache->nodes[head->next].prev = n; \
+    head->next = n; \
+} \
+\
+_funcspecs void _##_C##_touch(struct _C *cache, uint32_t n) \
+{ \
+    if (cache->policy == GCL_CACHE_CLOCK) { \
+        cache->nodes[n].referenced = true; \
+    } else if (cache->nodes[cache->capacity].next != n) { \
+        _##_C##_unlink(cache, n); \
+        _##_C##_link_front(cache, n); \
+    } \
+} \
+\
+_funcspecs void _##_C##_drop(struct _C *cache, uint32_t n) \
+{ \
+    struct _C##_node *node = &cache->nodes[n]; \
+\
+    if (cache->evict) \
+        cache->evict(node->key, node->val, cache->evict_arg); \
+\
+    _##_C##_unindex(cache, node->index); \
+    if (cache->policy == GCL_CACHE_LRU) \
+        _##_C##_unlink(cache, n); \
+    node->next = cache->free_head; \
+    cache->free_head = n; \
+    cache->length--; \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *cache) \
+{ \
+    return cache->length; \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *cache) \
+{ \
+    return cache->length == 0; \
+} \
+\
+_funcspecs size_t _C##_capacity(_C##_t *cache) \
+{ \
+    return cache->capacity; \
+} \
+\
+_funcspecs void _C##_set_evict(_C##_t *cache, void (*evict)(_K, _V, void *), void *arg) \
+{ \
+    cache->evict = evict; \
+    cache->evict_arg = arg; \
+} \
+\
+_funcspecs void _C##_reset_counters(_C##_t *cache) \
+{ \
+    cache->hits = 0; \
+    cache->misses = 0; \
+    cache->evictions = 0; \
+}
+
+#endif
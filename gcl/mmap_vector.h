@@ -0,0 +1,333 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A memory-mapped vector stores its elements in a file that is mapped with
+ * MAP_SHARED, so that a vector built once can be reopened without copying
+ * and its pages are shared between all processes that map the file.  The
+ * element type must be trivially copyable; the destroy_elem member is always
+ * NULL.
+ *
+ * The file starts with a header of GCL_MMAP_VECTOR_HEADER_SIZE bytes, which
+ * is followed by the elements.  The length stored in the header is updated
+ * on resize, _C##_sync and close_##_C.  A vector opened read-only must not
+ * be modified.
+ */
+
+#ifndef GCL_MMAP_VECTOR_H
+#define GCL_MMAP_VECTOR_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "vector.h"
+
+#define GCL_MMAP_VECTOR_MAGIC           UINT64_C(0x67636c6d76656331)
+#define GCL_MMAP_VECTOR_HEADER_SIZE     (64)
+
+#define GCL_MMAP_VECTOR_RDONLY          (1 << 0)
+#define GCL_MMAP_VECTOR_CREATE          (1 << 1)
+#define GCL_MMAP_VECTOR_TRUNC           (1 << 2)
+#define GCL_MMAP_VECTOR_POPULATE        (1 << 3)
+
+#ifdef MAP_POPULATE
+#define _GCL_MMAP_VECTOR_POPULATE_FLAG(flags)   ((flags) |= MAP_POPULATE)
+#else
+#define _GCL_MMAP_VECTOR_POPULATE_FLAG(flags)   ((void) (flags))
+#endif
+
+struct gcl_mmap_vector_header {
+    uint64_t magic;
+    uint64_t length;
+    uint64_t capacity;
+    uint64_t elem_size;
+};
+
+#define GCL_GENERATE_MMAP_VECTOR_TYPES(_C, _T) \
+\
+typedef struct _C _C##_t; \
+typedef _T *_C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef _T _C##_elem_t; \
+\
+struct _C##_range { \
+    _T *begin; \
+    _T *end; \
+}; \
+\
+struct _C { \
+    _T *data; \
+    _T *data_end; \
+    _T *end; \
+    void (*destroy_elem)(_T); \
+    const struct gcl_growth_policy *policy; \
+    struct gcl_mmap_vector_header *header; \
+    int fd; \
+    int flags; \
+};
+
+#define GCL_GENERATE_MMAP_VECTOR_FUNCTIONS_STATIC(_C, _T) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, static inline) \
+    GCL_GENERATE_MMAP_VECTOR_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_MMAP_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_MMAP_VECTOR_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_MMAP_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_MMAP_VECTOR_FUNCTIONS_EXTERN_H(_C, _T) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, inline) \
+    GCL_GENERATE_MMAP_VECTOR_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_MMAP_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_MMAP_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_MMAP_VECTOR_FUNCTIONS_EXTERN_C(_C, _T) \
+    _gcl_stats_define_extern(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_MMAP_VECTOR_LONG_FUNCTION_DEFS(_C, _T, ) \
+    GCL_GENERATE_MMAP_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, )
+
+#define GCL_GENERATE_MMAP_VECTOR_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs bool _##_C##_map(struct _C *vec, size_t n); \
+_funcspecs _T *_##_C##_do_resize(struct _C *vec, size_t n); \
+_funcspecs _T *open_##_C(struct _C *vec, const char *path, int flags); \
+_funcspecs bool close_##_C(struct _C *vec); \
+_funcspecs bool _C##_sync(_C##_t *vec); \
+_funcspecs bool _C##_advise(_C##_t *vec, int advice); \
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DECLS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_MMAP_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs size_t _##_C##_map_size(size_t n); \
+_funcspecs void _##_C##_unmap(struct _C *vec); \
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2);
+
+#define GCL_GENERATE_MMAP_VECTOR_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs bool _##_C##_map(struct _C *vec, size_t n) \
+{ \
+    bool rdonly = vec->flags & GCL_MMAP_VECTOR_RDONLY; \
+    int mmap_flags = MAP_SHARED; \
+    char *base; \
+\
+    if (vec->flags & GCL_MMAP_VECTOR_POPULATE) { \
+        _GCL_MMAP_VECTOR_POPULATE_FLAG(mmap_flags); \
+    } \
+\
+    base = mmap(NULL, _##_C##_map_size(n), \
+                rdonly ? PROT_READ : PROT_READ | PROT_WRITE, \
+                mmap_flags, vec->fd, 0); \
+\
+    if (base == MAP_FAILED) { \
+        GCL_ERROR(errno, "Mapping vector file failed"); \
+        return false; \
+    } \
+\
+    vec->header = (struct gcl_mmap_vector_header *) base; \
+    vec->data = (_T *) (base + GCL_MMAP_VECTOR_HEADER_SIZE); \
+    vec->data_end = vec->data + n; \
+    return true; \
+} \
+\
+_funcspecs _T *_##_C##_do_resize(struct _C *vec, size_t n) \
+{ \
+    assert(n >= _gcl_vector_length(vec) && n <= _C##_max_capacity()); \
+\
+    size_t length = _gcl_vector_length(vec); \
+    size_t capacity = _gcl_vector_capacity(vec); \
+    struct gcl_mmap_vector_header *old_header = vec->header; \
+    _T *old_data = vec->data; \
+\
+    if (n < GCL_VECTOR_MINIMAL_CAPACITY) \
+        n = GCL_VECTOR_MINIMAL_CAPACITY; \
+\
+    if (n == capacity) \
+        return vec->data; \
+\
+    if (vec->flags & GCL_MMAP_VECTOR_RDONLY) { \
+        GCL_ERROR(EBADF, "Resizing read-only vector file failed"); \
+        return NULL; \
+    } \
+\
+    if (n > capacity && ftruncate(vec->fd, (off_t) _##_C##_map_size(n))) { \
+        GCL_ERROR(errno, "Extending vector file failed"); \
+        return NULL; \
+    } \
+\
+    /* Map the new size first so that a failed resize leaves vec unchanged. */ \
+    if (!_##_C##_map(vec, n)) { \
+        vec->header = old_header; \
+        vec->data = old_data; \
+        vec->data_end = old_data + capacity; \
+        return NULL; \
+    } \
+\
+    munmap(old_header, _##_C##_map_size(capacity)); \
+\
+    if (n < capacity && ftruncate(vec->fd, (off_t) _##_C##_map_size(n))) { \
+        GCL_ERROR(errno, "Truncating vector file failed"); \
+    } \
+\
+    _gcl_stats_resize(_C, n, length); \
+    vec->end = vec->data + length; \
+    vec->header->length = length; \
+    vec->header->capacity = n; \
+    return vec->data; \
+} \
+\
+_funcspecs _T *open_##_C(struct _C *vec, const char *path, int flags) \
+{ \
+    int open_flags = flags & GCL_MMAP_VECTOR_RDONLY ? O_RDONLY : O_RDWR; \
+    struct stat st; \
+    size_t n; \
+\
+    if (flags & GCL_MMAP_VECTOR_CREATE) \
+        open_flags |= O_CREAT; \
+    if (flags & GCL_MMAP_VECTOR_TRUNC) \
+        open_flags |= O_TRUNC; \
+\
+    *vec = (struct _C) { \
+        .data = NULL, \
+        .data_end = NULL, \
+        .end = NULL, \
+        .destroy_elem = NULL, \
+        .policy = NULL, \
+        .header = NULL, \
+        .fd = open(path, open_flags, 0666), \
+        .flags = flags \
+    }; \
+\
+    if (vec->fd < 0) { \
+        GCL_ERROR(errno, "Opening vector file failed"); \
+        return NULL; \
+    } \
+\
+    if (fstat(vec->fd, &st)) { \
+        GCL_ERROR(errno, "Querying vector file size failed"); \
+        goto error; \
+    } \
+\
+    if (st.st_size == 0 && !(flags & GCL_MMAP_VECTOR_RDONLY)) { \
+        n = GCL_VECTOR_INITIAL_CAPACITY; \
+\
+        if (ftruncate(vec->fd, (off_t) _##_C##_map_size(n))) { \
+            GCL_ERROR(errno, "Extending vector file failed"); \
+            goto error; \
+        } \
+\
+        if (!_##_C##_map(vec, n)) \
+            goto error; \
+\
+        *vec->header = (struct gcl_mmap_vector_header) { \
+            .magic = GCL_MMAP_VECTOR_MAGIC, \
+            .length = 0, \
+            .capacity = n, \
+            .elem_size = sizeof(_T) \
+        }; \
+    } else { \
+        struct gcl_mmap_vector_header header; \
+\
+        if (pread(vec->fd, &header, sizeof(header), 0) != (ssize_t) sizeof(header)) { \
+            GCL_ERROR(EINVAL, "Reading vector file header failed"); \
+            goto error; \
+        } \
+\
+        if (header.magic != GCL_MMAP_VECTOR_MAGIC \
+            || header.elem_size != sizeof(_T) \
+            || header.length > header.capacity \
+            || header.capacity > _C##_max_capacity() \
+            || (size_t) st.st_size < _##_C##_map_size(header.capacity)) { \
+            GCL_ERROR(EINVAL, "Vector file has an invalid header"); \
+            goto error; \
+        } \
+\
+        if (!_##_C##_map(vec, header.capacity)) \
+            goto error; \
+    } \
+\
+    vec->end = vec->data + vec->header->length; \
+    _gcl_stats_length(_C, vec->header->length); \
+    _gcl_stats_capacity(_C, _gcl_vector_capacity(vec), vec->header->length); \
+    return vec->data; \
+\
+error: \
+    close(vec->fd); \
+    vec->fd = -1; \
+    return NULL; \
+} \
+\
+_funcspecs bool close_##_C(struct _C *vec) \
+{ \
+    if (!(vec->flags & GCL_MMAP_VECTOR_RDONLY)) \
+        vec->header->length = _gcl_vector_length(vec); \
+\
+    _##_C##_unmap(vec); \
+\
+    if (close(vec->fd)) { \
+        GCL_ERROR(errno, "Closing vector file failed"); \
+        return false; \
+    } \
+\
+    vec->fd = -1; \
+    return true; \
+} \
+\
+_funcspecs bool _C##_sync(_C##_t *vec) \
+{ \
+    if (vec->flags & GCL_MMAP_VECTOR_RDONLY) \
+        return true; \
+\
+    vec->header->length = _gcl_vector_length(vec); \
+\
+    if (msync(vec->header, _##_C##_map_size(_gcl_vector_capacity(vec)), MS_SYNC)) { \
+        GCL_ERROR(errno, "Synchronizing vector file failed"); \
+        return false; \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs bool _C##_advise(_C##_t *vec, int advice) \
+{ \
+    if (madvise(vec->header, _##_C##_map_size(_gcl_vector_capacity(vec)), advice)) { \
+        GCL_ERROR(errno, "Setting memory advice for vector file failed"); \
+        return false; \
+    } \
+\
+    return true; \
+} \
+\
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DEFS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_MMAP_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs size_t _##_C##_map_size(size_t n) \
+{ \
+    return GCL_MMAP_VECTOR_HEADER_SIZE + n * sizeof(_T); \
+} \
+\
+_funcspecs void _##_C##_unmap(struct _C *vec) \
+{ \
+    munmap(vec->header, _##_C##_map_size(_gcl_vector_capacity(vec))); \
+    vec->header = NULL; \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2) \
+{ \
+    struct _C tmp = *vec1; \
+    *vec1 = *vec2; \
+    *vec2 = tmp; \
+}
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * An unbounded lock-free multi-producer single-consumer queue that links
+ * objects through an embedded struct gcl_mpsc_link member, following
+ * Vyukov's intrusive MPSC algorithm.  _C##_push may be called from any
+ * thread and costs one atomic exchange; _C##_pop, _C##_pop_all and
+ * _C##_batch_pop must only be called from the consumer thread and never
+ * loop on a CAS.
+ *
+ * _C##_pop returns NULL if the queue is empty or if a producer has swapped
+ * itself in but not yet published its link; the consumer should retry
+ * later.  _C##_pop_all detaches everything pushed so far in O(1); the
+ * returned batch must be drained with _C##_batch_pop before the next call
+ * to _C##_pop_all.  Because a batch ends only at its last element,
+ * _C##_batch_pop does not return early like _C##_pop: if it reaches a
+ * producer whose push is still in flight, it spins until that producer
+ * has published its link, so it is not lock-free.
+ *
+ * Requires C11 atomics.
+ */
+
+#ifndef GCL_MPSC_QUEUE_H
+#define GCL_MPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define _gcl_container_of(ptr, _T, member) \
+    ((_T *) ((char *) (ptr) - offsetof(_T, member)))
+
+struct gcl_mpsc_link {
+    _Atomic(struct gcl_mpsc_link *) next;
+};
+
+#define GCL_GENERATE_MPSC_QUEUE_TYPES(_C, _T, _link) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_batch _C##_batch_t; \
+typedef _T *_C##_elem_t; \
+\
+struct _C##_batch { \
+    struct gcl_mpsc_link *next; \
+    struct gcl_mpsc_link *last; \
+    struct gcl_mpsc_link *stub; \
+}; \
+\
+struct _C { \
+    _Atomic(struct gcl_mpsc_link *) head; \
+    struct gcl_mpsc_link *tail; \
+    unsigned stub; \
+    struct gcl_mpsc_link stubs[2]; \
+};
+
+#define GCL_GENERATE_MPSC_QUEUE_FUNCTIONS_STATIC(_C, _T, _link) \
+    GCL_GENERATE_MPSC_QUEUE_LONG_FUNCTION_DECLS(_C, _T, _link, static) \
+    GCL_GENERATE_MPSC_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, _link, static inline) \
+    GCL_GENERATE_MPSC_QUEUE_LONG_FUNCTION_DEFS(_C, _T, _link, static) \
+    GCL_GENERATE_MPSC_QUEUE_SHORT_FUNCTION_DEFS(_C, _T, _link, static inline)
+
+#define GCL_GENERATE_MPSC_QUEUE_FUNCTIONS_EXTERN_H(_C, _T, _link) \
+    GCL_GENERATE_MPSC_QUEUE_LONG_FUNCTION_DECLS(_C, _T, _link, ) \
+    GCL_GENERATE_MPSC_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, _link, inline) \
+    GCL_GENERATE_MPSC_QUEUE_SHORT_FUNCTION_DEFS(_C, _T, _link, inline)
+
+#define GCL_GENERATE_MPSC_QUEUE_FUNCTIONS_EXTERN_C(_C, _T, _link) \
+    GCL_GENERATE_MPSC_QUEUE_LONG_FUNCTION_DEFS(_C, _T, _link, ) \
+    GCL_GENERATE_MPSC_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, _link, )
+
+#define GCL_GENERATE_MPSC_QUEUE_LONG_FUNCTION_DECLS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs _T *_C##_pop(_C##_t *queue); \
+_funcspecs _C##_batch_t _C##_pop_all(_C##_t *queue); \
+_funcspecs _T *_C##_batch_pop(_C##_batch_t *batch);
+
+#define GCL_GENERATE_MPSC_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs void init_##_C(struct _C *queue); \
+_funcspecs _T *_##_C##_entry(struct gcl_mpsc_link *link); \
+_funcspecs void _##_C##_push_link(struct _C *queue, struct gcl_mpsc_link *link); \
+_funcspecs void _C##_push(_C##_t *queue, _T *obj); \
+_funcspecs bool _C##_empty(_C##_t *queue);
+
+#define GCL_GENERATE_MPSC_QUEUE_LONG_FUNCTION_DEFS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs _T *_C##_pop(_C##_t *queue) \
+{ \
+    struct gcl_mpsc_link *stub = &queue->stubs[queue->stub]; \
+    struct gcl_mpsc_link *tail = queue->tail; \
+    struct gcl_mpsc_link *next = atomic_load_explicit(&tail->next, memory_order_acquire); \
+\
+    if (tail == stub) { \
+        if (!next) \
+            return NULL; \
+        queue->tail = tail = next; \
+        next = atomic_load_explicit(&tail->next, memory_order_acquire); \
+    } \
+\
+    if (next) { \
+        queue->tail = next; \
+        return _##_C##_entry(tail); \
+    } \
+\
+    if (tail != atomic_load_explicit(&queue->head, memory_order_acquire)) \
+        return NULL; \
+\
+    _##_C##_push_link(queue, stub); \
+    next = atomic_load_explicit(&tail->next, memory_order_acquire); \
+\
+    if (next) { \
+        queue->tail = next; \
+        return _##_C##_entry(tail); \
+    } \
+\
+    return NULL; \
+} \
+\
+_funcspecs _C##_batch_t _C##_pop_all(_C##_t *queue) \
+{ \
+    struct gcl_mpsc_link *stub = &queue->stubs[queue->stub]; \
+    struct gcl_mpsc_link *new_stub = &queue->stubs[queue->stub ^ 1]; \
+    struct _C##_batch batch = { .next = queue->tail, .last = NULL, .stub = stub }; \
+\
+    if (batch.next == stub && !atomic_load_explicit(&stub->next, memory_order_acquire)) \
+        return (struct _C##_batch) { NULL, NULL, stub }; \
+\
+    atomic_store_explicit(&new_stub->next, NULL, memory_order_relaxed); \
+    batch.last = atomic_exchange_explicit(&queue->head, new_stub, memory_order_acq_rel); \
+    queue->tail = new_stub; \
+    queue->stub ^= 1; \
+    return batch; \
+} \
+\
+_funcspecs _T *_C##_batch_pop(_C##_batch_t *batch) \
+{ \
+    struct gcl_mpsc_link *link, *next; \
+\
+    while ((link = batch->next)) { \
+        if (link == batch->last) { \
+            batch->next = NULL; \
+        } else { \
+            /* Wait for a producer that has not yet published its link. */ \
+            while (!(next = atomic_load_explicit(&link->next, memory_order_acquire))) \
+                ; \
+            batch->next = next; \
+        } \
+\
+        if (link != batch->stub) \
+            return _##_C##_entry(link); \
+    } \
+\
+    return NULL; \
+}
+
+#define GCL_GENERATE_MPSC_QUEUE_SHORT_FUNCTION_DEFS(_C, _T, _link, _funcspecs) \
+\
+_funcspecs void init_##_C(struct _C *queue) \
+{ \
+    atomic_init(&queue->stubs[0].next, NULL); \
+    atomic_init(&queue->stubs[1].next, NULL); \
+    atomic_init(&queue->head, &queue->stubs[0]); \
+    queue->tail = &queue->stubs[0]; \
+    queue->stub = 0; \
+} \
+\
+_funcspecs _T *_##_C##_entry(struct gcl_mpsc_link *link) \
+{ \
+    return _gcl_container_of(link, _T, _link); \
+} \
+\
+_funcspecs void _##_C##_push_link(struct _C *queue, struct gcl_mpsc_link *link) \
+{ \
+    struct gcl_mpsc_link *prev; \
+\
+    atomic_store_explicit(&link->next, NULL, memory_order_relaxed); \
+    prev = atomic_exchange_explicit(&queue->head, link, memory_order_acq_rel); \
+    atomic_store_explicit(&prev->next, link, memory_order_release); \
+} \
+\
+_funcspecs void _C##_push(_C##_t *queue, _T *obj) \
+{ \
+    _##_C##_push_link(queue, &obj->_link); \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *queue) \
+{ \
+    struct gcl_mpsc_link *tail = queue->tail; \
+\
+    return tail == &queue->stubs[queue->stub] \
+           && !atomic_load_explicit(&tail->next, memory_order_acquire); \
+}
+
+#endif
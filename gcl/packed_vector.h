@@ -0,0 +1,443 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A vector of unsigned integers stored with a fixed number of bits per
+ * element, packed into a vector of 64-bit words.  Element i occupies bits
+ * i * width to (i + 1) * width - 1, so _C##_at is O(1).
+ *
+ * The width is given to init_##_C.  A width of 0 makes the vector
+ * adaptive: it starts at width 0 and is repacked to a larger width when a
+ * value does not fit.  _C##_set_width repacks explicitly and
+ * _C##_fit_width repacks to the smallest width that holds all elements.
+ * Setting an element through a position never changes the width; the value
+ * must fit.
+ *
+ * Positions are (vector, index) pairs, so the vector works with the range
+ * algorithms in alg.h except for those that need _C##_get_ptr.
+ */
+
+#ifndef GCL_PACKED_VECTOR_H
+#define GCL_PACKED_VECTOR_H
+
+#include "bits.h"
+#include "vector.h"
+
+#define _gcl_packed_vector_num_words(n, width)  (((n) * (width) + 63) / 64)
+
+#define GCL_GENERATE_PACKED_VECTOR_TYPES(_C) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_words, uint64_t) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_pos _C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef uint64_t _C##_elem_t; \
+\
+struct _C { \
+    struct _C##_words words; \
+    size_t length; \
+    unsigned width; \
+    bool adaptive; \
+}; \
+\
+struct _C##_pos { \
+    struct _C *vec; \
+    size_t i; \
+}; \
+\
+struct _C##_range { \
+    struct _C##_pos begin; \
+    struct _C##_pos end; \
+};
+
+#define GCL_GENERATE_PACKED_VECTOR_FUNCTIONS_STATIC(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_words, uint64_t) \
+    GCL_GENERATE_PACKED_VECTOR_LONG_FUNCTION_DECLS(_C, static) \
+    GCL_GENERATE_PACKED_VECTOR_SHORT_FUNCTION_DECLS(_C, static inline) \
+    GCL_GENERATE_PACKED_VECTOR_LONG_FUNCTION_DEFS(_C, static) \
+    GCL_GENERATE_PACKED_VECTOR_SHORT_FUNCTION_DEFS(_C, static inline)
+
+#define GCL_GENERATE_PACKED_VECTOR_FUNCTIONS_EXTERN_H(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_words, uint64_t) \
+    GCL_GENERATE_PACKED_VECTOR_LONG_FUNCTION_DECLS(_C, ) \
+    GCL_GENERATE_PACKED_VECTOR_SHORT_FUNCTION_DECLS(_C, inline) \
+    GCL_GENERATE_PACKED_VECTOR_SHORT_FUNCTION_DEFS(_C, inline)
+
+#define GCL_GENERATE_PACKED_VECTOR_FUNCTIONS_EXTERN_C(_C) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_words, uint64_t) \
+    GCL_GENERATE_PACKED_VECTOR_LONG_FUNCTION_DEFS(_C, ) \
+    GCL_GENERATE_PACKED_VECTOR_SHORT_FUNCTION_DECLS(_C, )
+
+#define GCL_GENERATE_PACKED_VECTOR_LONG_FUNCTION_DECLS(_C, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *vec, size_t n, unsigned width); \
+_funcspecs void destroy_##_C(struct _C *vec); \
+_funcspecs bool _##_C##_ensure(struct _C *vec, size_t n, unsigned width); \
+_funcspecs void _##_C##_truncate(struct _C *vec, size_t n); \
+_funcspecs bool _##_C##_fit(struct _C *vec, uint64_t val); \
+_funcspecs bool _C##_set_width(_C##_t *vec, unsigned width); \
+_funcspecs bool _C##_fit_width(_C##_t *vec); \
+_funcspecs bool _C##_reserve(_C##_t *vec, size_t n); \
+_funcspecs bool _C##_resize(_C##_t *vec, size_t n); \
+_funcspecs bool _C##_assign(_C##_t *vec, size_t i, uint64_t val); \
+_funcspecs bool _C##_insert_back(_C##_t *vec, uint64_t val); \
+_funcspecs bool _C##_insert_back_array(_C##_t *vec, const uint64_t *src, size_t n); \
+_funcspecs void _C##_clear(_C##_t *vec); \
+_funcspecs void _C##_shrink(_C##_t *vec); \
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2);
+
+#define GCL_GENERATE_PACKED_VECTOR_SHORT_FUNCTION_DECLS(_C, _funcspecs) \
+\
+_funcspecs _C##_pos_t _##_C##_pos(struct _C *vec, size_t i); \
+_funcspecs size_t _C##_length(_C##_t *vec); \
+_funcspecs bool _C##_empty(_C##_t *vec); \
+_funcspecs unsigned _C##_width(_C##_t *vec); \
+_funcspecs uint64_t _C##_at(_C##_t *vec, size_t i); \
+_funcspecs uint64_t _C##_front(_C##_t *vec); \
+_funcspecs uint64_t _C##_back(_C##_t *vec); \
+_funcspecs void _C##_remove_back(_C##_t *vec); \
+_funcspecs _C##_pos_t _C##_begin(_C##_t *vec); \
+_funcspecs _C##_pos_t _C##_end(_C##_t *vec); \
+_funcspecs bool _C##_at_begin(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs bool _C##_at_end(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos); \
+_funcspecs void _C##_forward(_C##_pos_t *pos); \
+_funcspecs void _C##_backward(_C##_pos_t *pos); \
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end); \
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range); \
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range); \
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_all(_C##_t *vec); \
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs size_t _C##_range_length(_C##_range_t range); \
+_funcspecs bool _C##_range_empty(_C##_range_t range); \
+_funcspecs uint64_t _C##_get(_C##_pos_t pos); \
+_funcspecs void _C##_set(_C##_pos_t pos, uint64_t val);
+
+#define GCL_GENERATE_PACKED_VECTOR_LONG_FUNCTION_DEFS(_C, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *vec, size_t n, unsigned width) \
+{ \
+    assert(width <= 64); \
+\
+    vec->length = 0; \
+    vec->width = width; \
+    vec->adaptive = width == 0; \
+\
+    return init_##_C##_words(&vec->words, _gcl_packed_vector_num_words(n, width), NULL) != NULL; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *vec) \
+{ \
+    destroy_##_C##_words(&vec->words); \
+} \
+\
+/* Makes room for n elements of the given width, zeroing the new words. */ \
+_funcspecs bool _##_C##_ensure(struct _C *vec, size_t n, unsigned width) \
+{ \
+    size_t num_words = _gcl_packed_vector_num_words(n, width); \
+    size_t length = _gcl_vector_length(&vec->words); \
+\
+    if (num_words <= length) \
+        return true; \
+\
+    if (!_C##_words_reserve(&vec->words, num_words)) \
+        return false; \
+\
+    memset(vec->words.end, 0, (num_words - length) * sizeof(uint64_t)); \
+    vec->words.end = vec->words.data + num_words; \
+    return true; \
+} \
+\
+/* Cuts the vector to n elements, keeping the bits past the end zero. */ \
+_funcspecs void _##_C##_truncate(struct _C *vec, size_t n) \
+{ \
+    size_t bits = n * vec->width; \
+\
+    vec->length = n; \
+    vec->words.end = vec->words.data + _gcl_packed_vector_num_words(n, vec->width); \
+    if (bits % 64) \
+        vec->words.data[bits / 64] &= ((uint64_t) 1 << (bits % 64)) - 1; \
+} \
+\
+/* Widens an adaptive vector so that val fits. */ \
+_funcspecs bool _##_C##_fit(struct _C *vec, uint64_t val) \
+{ \
+    unsigned width = _gcl_bit_width64(val); \
+\
+    if (width <= vec->width) \
+        return true; \
+\
+    assert(vec->adaptive); \
+    return _C##_set_width(vec, width); \
+} \
+\
+_funcspecs bool _C##_set_width(_C##_t *vec, unsigned width) \
+{ \
+    unsigned old_width = vec->width; \
+    size_t i; \
+\
+    assert(width <= 64); \
+\
+    if (width > old_width) { \
+        if (!_##_C##_ensure(vec, vec->length, width)) \
+            return false; \
+        for (i = vec->length; i-- > 0; ) \
+            _gcl_bits_put(vec->words.data, i * width, width, \
+                          _gcl_bits_get(vec->words.data, i * old_width, old_width)); \
+    } else if (width < old_width) { \
+        for (i = 0; i < vec->length; i++) { \
+            uint64_t val = _gcl_bits_get(vec->words.data, i * old_width, old_width); \
+            assert(_gcl_bit_width64(val) <= width); \
+            _gcl_bits_put(vec->words.data, i * width, width, val); \
+        } \
+    } \
+\
+    vec->width = width; \
+    _##_C##_truncate(vec, vec->length); \
+    return true; \
+} \
+\
+_funcspecs bool _C##_fit_width(_C##_t *vec) \
+{ \
+    uint64_t bits = 0; \
+    size_t i; \
+\
+    for (i = 0; i < vec->length; i++) \
+        bits |= _C##_at(vec, i); \
+\
+    return _C##_set_width(vec, _gcl_bit_width64(bits)); \
+} \
+\
+_funcspecs bool _C##_reserve(_C##_t *vec, size_t n) \
+{ \
+    return _C##_words_reserve(&vec->words, _gcl_packed_vector_num_words(n, vec->width)) != NULL; \
+} \
+\
+_funcspecs bool _C##_resize(_C##_t *vec, size_t n) \
+{ \
+    if (n > vec->length) { \
+        if (!_##_C##_ensure(vec, n, vec->width)) \
+            return false; \
+        vec->length = n; \
+    } else { \
+        _##_C##_truncate(vec, n); \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs bool _C##_assign(_C##_t *vec, size_t i, uint64_t val) \
+{ \
+    assert(i < vec->length); \
+\
+    if (!_##_C##_fit(vec, val)) \
+        return false; \
+\
+    _gcl_bits_put(vec->words.data, i * vec->width, vec->width, val); \
+    return true; \
+} \
+\
+_funcspecs bool _C##_insert_back(_C##_t *vec, uint64_t val) \
+{ \
+    if (!_##_C##_fit(vec, val) || !_##_C##_ensure(vec, vec->length + 1, vec->width)) \
+        return false; \
+\
+    _gcl_bits_put(vec->words.data, vec->length * vec->width, vec->width, val); \
+    vec->length++; \
+    return true; \
+} \
+\
+_funcspecs bool _C##_insert_back_array(_C##_t *vec, const uint64_t *src, size_t n) \
+{ \
+    uint64_t bits = 0; \
+    size_t i; \
+\
+    for (i = 0; i < n; i++) \
+        bits |= src[i]; \
+\
+    if (!_##_C##_fit(vec, bits) || !_##_C##_ensure(vec, vec->length + n, vec->width)) \
+        return false; \
+\
+    for (i = 0; i < n; i++) \
+        _gcl_bits_put(vec->words.data, (vec->length + i) * vec->width, vec->width, src[i]); \
+\
+    vec->length += n; \
+    return true; \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *vec) \
+{ \
+    _C##_words_clear(&vec->words); \
+    vec->length = 0; \
+} \
+\
+_funcspecs void _C##_shrink(_C##_t *vec) \
+{ \
+    _C##_words_shrink(&vec->words); \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2) \
+{ \
+    struct _C tmp = *vec1; \
+    *vec1 = *vec2; \
+    *vec2 = tmp; \
+}
+
+#define GCL_GENERATE_PACKED_VECTOR_SHORT_FUNCTION_DEFS(_C, _funcspecs) \
+\
+_funcspecs _C##_pos_t _##_C##_pos(struct _C *vec, size_t i) \
+{ \
+    return (struct _C##_pos) { .vec = vec, .i = i }; \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *vec) \
+{ \
+    return vec->length; \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *vec) \
+{ \
+    return vec->length == 0; \
+} \
+\
+_funcspecs unsigned _C##_width(_C##_t *vec) \
+{ \
+    return vec->width; \
+} \
+\
+_funcspecs uint64_t _C##_at(_C##_t *vec, size_t i) \
+{ \
+    assert(i < vec->length); \
+    return _gcl_bits_get(vec->words.data, i * vec->width, vec->width); \
+} \
+\
+_funcspecs uint64_t _C##_front(_C##_t *vec) \
+{ \
+    return _C##_at(vec, 0); \
+} \
+\
+_funcspecs uint64_t _C##_back(_C##_t *vec) \
+{ \
+    return _C##_at(vec, vec->length - 1); \
+} \
+\
+_funcspecs void _C##_remove_back(_C##_t *vec) \
+{ \
+    assert(!_C##_empty(vec)); \
+    _##_C##_truncate(vec, vec->length - 1); \
+} \
+\
+_funcspecs _C##_pos_t _C##_begin(_C##_t *vec) \
+{ \
+    return _##_C##_pos(vec, 0); \
+} \
+\
+_funcspecs _C##_pos_t _C##_end(_C##_t *vec) \
+{ \
+    return _##_C##_pos(vec, vec->length); \
+} \
+\
+_funcspecs bool _C##_at_begin(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    (void) vec; \
+    return pos.i == 0; \
+} \
+\
+_funcspecs bool _C##_at_end(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return pos.i == vec->length; \
+} \
+\
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos) \
+{ \
+    pos.i++; \
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos) \
+{ \
+    pos.i--; \
+    return pos; \
+} \
+\
+_funcspecs void _C##_forward(_C##_pos_t *pos) \
+{ \
+    pos->i++; \
+} \
+\
+_funcspecs void _C##_backward(_C##_pos_t *pos) \
+{ \
+    pos->i--; \
+} \
+\
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end) \
+{ \
+    return (struct _C##_range) { begin, end }; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range) \
+{ \
+    return range.begin; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range) \
+{ \
+    return range.end; \
+} \
+\
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.begin.i; \
+} \
+\
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.end.i; \
+} \
+\
+_funcspecs _C##_range_t _C##_all(_C##_t *vec) \
+{ \
+    return (struct _C##_range) { _C##_begin(vec), _C##_end(vec) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { pos, _C##_end(vec) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { _C##_begin(vec), pos }; \
+} \
+\
+_funcspecs size_t _C##_range_length(_C##_range_t range) \
+{ \
+    assert(range.begin.i <= range.end.i); \
+    return range.end.i - range.begin.i; \
+} \
+\
+_funcspecs bool _C##_range_empty(_C##_range_t range) \
+{ \
+    return range.begin.i == range.end.i; \
+} \
+\
+_funcspecs uint64_t _C##_get(_C##_pos_t pos) \
+{ \
+    return _C##_at(pos.vec, pos.i); \
+} \
+\
+_funcspecs void _C##_set(_C##_pos_t pos, uint64_t val) \
+{ \
+    assert(pos.i < pos.vec->length && _gcl_bit_width64(val) <= pos.vec->width); \
+    _gcl_bits_put(pos.vec->words.data, pos.i * pos.vec->width, pos.vec->width, val); \
+}
+
+#endif
@@ -0,0 +1,229 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A priority queue stored as a D-ary heap in a vector.  _cmp is a function
+ * or function-like macro as for the heap algorithms in alg.h; the top of
+ * the queue is the smallest element.  Wider heaps are shallower, so a
+ * 4-ary heap touches fewer cache lines per push and pop on large queues at
+ * the price of more comparisons per level.
+ *
+ * An indexed priority queue additionally calls _set_index(elem, i) every
+ * time it stores an element at heap index i.  Elements that record that
+ * index, typically pointers to objects with an index member, can then have
+ * their priority changed in place followed by _C##_update, or be removed
+ * with _C##_remove_at.
+ *
+ *     #define task_set_index(task, i)  ((task)->heap_index = (i))
+ *
+ *     GCL_GENERATE_PRIORITY_QUEUE_TYPES(task_queue, struct task *)
+ *     GCL_GENERATE_INDEXED_PRIORITY_QUEUE_FUNCTIONS_STATIC(task_queue, struct task *,
+ *                                                          task_cmp, 4, task_set_index)
+ */
+
+#ifndef GCL_PRIORITY_QUEUE_H
+#define GCL_PRIORITY_QUEUE_H
+
+#include "alg.h"
+#include "vector.h"
+
+#define GCL_GENERATE_PRIORITY_QUEUE_TYPES(_C, _T) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_heap, _T) \
+\
+typedef struct _C _C##_t; \
+typedef _T _C##_elem_t; \
+\
+struct _C { \
+    struct _C##_heap heap; \
+};
+
+#define GCL_GENERATE_PRIORITY_QUEUE_FUNCTIONS_STATIC(_C, _T, _cmp, _D) \
+    GCL_GENERATE_INDEXED_PRIORITY_QUEUE_FUNCTIONS_STATIC(_C, _T, _cmp, _D, _gcl_heap_no_index)
+
+#define GCL_GENERATE_PRIORITY_QUEUE_FUNCTIONS_EXTERN_H(_C, _T, _cmp, _D) \
+    GCL_GENERATE_INDEXED_PRIORITY_QUEUE_FUNCTIONS_EXTERN_H(_C, _T, _cmp, _D, _gcl_heap_no_index)
+
+#define GCL_GENERATE_PRIORITY_QUEUE_FUNCTIONS_EXTERN_C(_C, _T, _cmp, _D) \
+    GCL_GENERATE_INDEXED_PRIORITY_QUEUE_FUNCTIONS_EXTERN_C(_C, _T, _cmp, _D, _gcl_heap_no_index)
+
+#define GCL_GENERATE_INDEXED_PRIORITY_QUEUE_FUNCTIONS_STATIC(_C, _T, _cmp, _D, _set_index) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_heap, _T) \
+    GCL_GENERATE_PRIORITY_QUEUE_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_PRIORITY_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_PRIORITY_QUEUE_LONG_FUNCTION_DEFS(_C, _T, _cmp, _D, _set_index, static) \
+    GCL_GENERATE_PRIORITY_QUEUE_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_INDEXED_PRIORITY_QUEUE_FUNCTIONS_EXTERN_H(_C, _T, _cmp, _D, _set_index) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_heap, _T) \
+    GCL_GENERATE_PRIORITY_QUEUE_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_PRIORITY_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_PRIORITY_QUEUE_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_INDEXED_PRIORITY_QUEUE_FUNCTIONS_EXTERN_C(_C, _T, _cmp, _D, _set_index) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_heap, _T) \
+    GCL_GENERATE_PRIORITY_QUEUE_LONG_FUNCTION_DEFS(_C, _T, _cmp, _D, _set_index, ) \
+    GCL_GENERATE_PRIORITY_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, )
+
+#define GCL_GENERATE_PRIORITY_QUEUE_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs void _##_C##_sift_up(struct _C *pq, size_t i); \
+_funcspecs void _##_C##_sift_down(struct _C *pq, size_t i); \
+_funcspecs void _C##_heapify(_C##_t *pq); \
+_funcspecs bool _C##_push(_C##_t *pq, _T val); \
+_funcspecs bool _C##_push_array(_C##_t *pq, const _C##_elem_t *src, size_t n); \
+_funcspecs _T _C##_pop(_C##_t *pq); \
+_funcspecs void _C##_update(_C##_t *pq, size_t i); \
+_funcspecs _T _C##_remove_at(_C##_t *pq, size_t i);
+
+#define GCL_GENERATE_PRIORITY_QUEUE_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *init_##_C(struct _C *pq, size_t n, void (*destroy_elem)(_T)); \
+_funcspecs void destroy_##_C(struct _C *pq); \
+_funcspecs size_t _C##_length(_C##_t *pq); \
+_funcspecs bool _C##_empty(_C##_t *pq); \
+_funcspecs _T *_C##_reserve(_C##_t *pq, size_t n); \
+_funcspecs _T _C##_top(_C##_t *pq); \
+_funcspecs _T _C##_at(_C##_t *pq, size_t i); \
+_funcspecs void _C##_clear(_C##_t *pq); \
+_funcspecs void _C##_swap(_C##_t *pq1, _C##_t *pq2);
+
+#define GCL_GENERATE_PRIORITY_QUEUE_LONG_FUNCTION_DEFS(_C, _T, _cmp, _D, _set_index, _funcspecs) \
+\
+_funcspecs void _##_C##_sift_up(struct _C *pq, size_t i) \
+{ \
+    _gcl_heap_sift_up(_T, pq->heap.data, i, _cmp, _D, _set_index); \
+} \
+\
+_funcspecs void _##_C##_sift_down(struct _C *pq, size_t i) \
+{ \
+    _gcl_heap_sift_down(_T, pq->heap.data, _gcl_vector_length(&pq->heap), i, \
+                        _cmp, _D, _set_index); \
+} \
+\
+_funcspecs void _C##_heapify(_C##_t *pq) \
+{ \
+    size_t n = _gcl_vector_length(&pq->heap), i; \
+\
+    _gcl_heap_make(_T, pq->heap.data, n, _cmp, _D, _set_index); \
+\
+    /* _gcl_heap_make does not visit leaves that stay in place. */ \
+    for (i = 0; i < n; i++) \
+        _set_index(pq->heap.data[i], i); \
+} \
+\
+_funcspecs bool _C##_push(_C##_t *pq, _T val) \
+{ \
+    if (!_C##_heap_insert_back(&pq->heap, val)) \
+        return false; \
+\
+    _##_C##_sift_up(pq, _gcl_vector_length(&pq->heap) - 1); \
+    return true; \
+} \
+\
+_funcspecs bool _C##_push_array(_C##_t *pq, const _C##_elem_t *src, size_t n) \
+{ \
+    size_t length = _gcl_vector_length(&pq->heap), i; \
+\
+    if (!_C##_heap_reserve(&pq->heap, length + n)) \
+        return false; \
+\
+    memcpy(pq->heap.end, src, n * sizeof(_T)); \
+    pq->heap.end += n; \
+    _gcl_stats_length(_C##_heap, _gcl_vector_length(&pq->heap)); \
+\
+    if (n > length) { \
+        _C##_heapify(pq); \
+    } else { \
+        for (i = length; i < length + n; i++) \
+            _##_C##_sift_up(pq, i); \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs _T _C##_pop(_C##_t *pq) \
+{ \
+    assert(!_C##_empty(pq)); \
+    return _C##_remove_at(pq, 0); \
+} \
+\
+_funcspecs void _C##_update(_C##_t *pq, size_t i) \
+{ \
+    assert(i < _gcl_vector_length(&pq->heap)); \
+\
+    if (i > 0 && _cmp(pq->heap.data[i], pq->heap.data[(i - 1) / (_D)]) < 0) \
+        _##_C##_sift_up(pq, i); \
+    else \
+        _##_C##_sift_down(pq, i); \
+} \
+\
+_funcspecs _T _C##_remove_at(_C##_t *pq, size_t i) \
+{ \
+    assert(i < _gcl_vector_length(&pq->heap)); \
+\
+    _T val = pq->heap.data[i]; \
+\
+    pq->heap.end--; \
+    _gcl_stats_capacity(_C##_heap, _gcl_vector_capacity(&pq->heap), _gcl_vector_length(&pq->heap)); \
+    if (i < _gcl_vector_length(&pq->heap)) { \
+        pq->heap.data[i] = *pq->heap.end; \
+        _C##_update(pq, i); \
+    } \
+\
+    return val; \
+}
+
+#define GCL_GENERATE_PRIORITY_QUEUE_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *init_##_C(struct _C *pq, size_t n, void (*destroy_elem)(_T)) \
+{ \
+    return init_##_C##_heap(&pq->heap, n, destroy_elem); \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *pq) \
+{ \
+    destroy_##_C##_heap(&pq->heap); \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *pq) \
+{ \
+    return _gcl_vector_length(&pq->heap); \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *pq) \
+{ \
+    return _gcl_vector_length(&pq->heap) == 0; \
+} \
+\
+_funcspecs _T *_C##_reserve(_C##_t *pq, size_t n) \
+{ \
+    return _C##_heap_reserve(&pq->heap, n); \
+} \
+\
+_funcspecs _T _C##_top(_C##_t *pq) \
+{ \
+    assert(!_C##_empty(pq)); \
+    return pq->heap.data[0]; \
+} \
+\
+_funcspecs _T _C##_at(_C##_t *pq, size_t i) \
+{ \
+    assert(i < _gcl_vector_length(&pq->heap)); \
+    return pq->heap.data[i]; \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *pq) \
+{ \
+    _C##_heap_clear(&pq->heap); \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *pq1, _C##_t *pq2) \
+{ \
+    _C##_heap_swap(&pq1->heap, &pq2->heap); \
+}
+
+#endif
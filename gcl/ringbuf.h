@@ -20,6 +20,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "alloc.h"
+#include "growth.h"
+#include "stats.h"
+#include "traits.h"
+
 #define GCL_RINGBUF_MINIMAL_CAPACITY    (15)
 #define GCL_RINGBUF_INITIAL_CAPACITY    (15)
 #define GCL_RINGBUF_GROWTH_FACTOR       (2)
@@ -32,6 +37,15 @@
          (ptr) != (buf)->end; \
          _gcl_ringbuf_forward(buf, ptr))
 
+/*
+ * _C##_steal_buffer linearizes the elements in place and hands the storage
+ * to the caller, which can adopt it into a vector without copying; the ring
+ * buffer is left empty and without storage and must be re-initialized (or
+ * adopt a buffer) before further use.  _C##_adopt_buffer takes over a block
+ * of capacity elements, such as the storage of a vector, of which the first
+ * length are in use; since a ring buffer needs one free slot, a full block
+ * is reallocated.
+ */
 #define GCL_GENERATE_RINGBUF_TYPES(_C, _T) \
 \
 typedef struct _C _C##_t; \
@@ -55,36 +69,69 @@ struct _C { \
     _T *begin; \
     _T *end; \
     void (*destroy_elem)(_T); \
+    const struct gcl_growth_policy *policy; \
 };
 
 #define GCL_GENERATE_RINGBUF_FUNCTIONS_STATIC(_C, _T) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, static inline) \
     GCL_GENERATE_RINGBUF_LONG_FUNCTION_DECLS(_C, _T, static) \
     GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
     GCL_GENERATE_RINGBUF_LONG_FUNCTION_DEFS(_C, _T, static) \
     GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DEFS(_C, _T, static inline)
 
 #define GCL_GENERATE_RINGBUF_FUNCTIONS_EXTERN_H(_C, _T) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, inline) \
     GCL_GENERATE_RINGBUF_LONG_FUNCTION_DECLS(_C, _T, ) \
     GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DECLS(_C, _T, inline) \
     GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DEFS(_C, _T, inline)
 
 #define GCL_GENERATE_RINGBUF_FUNCTIONS_EXTERN_C(_C, _T) \
+    _gcl_stats_define_extern(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, ) \
     GCL_GENERATE_RINGBUF_LONG_FUNCTION_DEFS(_C, _T, ) \
     GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DECLS(_C, _T, )
 
+#define GCL_GENERATE_RINGBUF_FUNCTIONS_STATIC_EX(_C, _T, traits) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, static inline) \
+    GCL_GENERATE_RINGBUF_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_RINGBUF_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_RINGBUF_FUNCTIONS_EXTERN_H_EX(_C, _T, traits) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, inline) \
+    GCL_GENERATE_RINGBUF_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_RINGBUF_FUNCTIONS_EXTERN_C_EX(_C, _T, traits) \
+    GCL_GENERATE_RINGBUF_FUNCTIONS_EXTERN_C(_C, _T)
+
 #define GCL_GENERATE_RINGBUF_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
 \
 _funcspecs _T *_##_C##_do_resize_shrink(struct _C *buf, size_t n); \
 _funcspecs _T *_##_C##_do_resize_grow(struct _C *buf, size_t n); \
 _funcspecs _T *_##_C##_grow(struct _C *buf); \
-_funcspecs _T *init__C(struct _C *buf, size_t n, void (*destroy_elem)(_T)); \
-_funcspecs void destroy__C(struct _C *buf); \
+_funcspecs _T *init_##_C(struct _C *buf, size_t n, void (*destroy_elem)(_T)); \
+_funcspecs void destroy_##_C(struct _C *buf); \
 _funcspecs _C##_pos_t _C##_insert(_C##_t *buf, _C##_pos_t pos, _T val); \
 _funcspecs _C##_pos_t _C##_insert_front(_C##_t *buf, _T val); \
 _funcspecs _C##_pos_t _C##_insert_back(_C##_t *buf, _T val); \
 _funcspecs _C##_pos_t _C##_release(_C##_t *buf, _C##_pos_t pos); \
 _funcspecs _C##_pos_t _C##_remove(_C##_t *buf, _C##_pos_t pos); \
-_funcspecs void _C##_clear(_C##_t *buf);
+_funcspecs void _C##_clear(_C##_t *buf); \
+_funcspecs void _C##_linearize(_C##_t *buf); \
+_funcspecs _T *_C##_adopt_buffer(_C##_t *buf, _T *data, size_t length, size_t capacity); \
+_funcspecs _T *_C##_steal_buffer(_C##_t *buf, size_t *length, size_t *capacity); \
+_funcspecs void _C##_swap(_C##_t *buf1, _C##_t *buf2);
 
 #define GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
 \
@@ -104,10 +151,12 @@ _funcspecs size_t _##_C##_index_of_ptr(struct _C *buf, _T *ptr); \
 _funcspecs bool _##_C##_contiguous(struct _C *buf); \
 _funcspecs bool _##_C##_full(struct _C *buf); \
 _funcspecs void _##_C##_move_data(_T *begin, _T *end, _T *dest); \
+_funcspecs void _##_C##_reverse_data(_T *begin, _T *end); \
 _funcspecs size_t _C##_length(_C##_t *buf); \
 _funcspecs bool _C##_empty(_C##_t *buf); \
 _funcspecs size_t _C##_capacity(_C##_t *buf); \
 _funcspecs size_t _C##_max_capacity(void); \
+_funcspecs void _C##_set_policy(_C##_t *buf, const struct gcl_growth_policy *policy); \
 _funcspecs _T *_C##_reserve(_C##_t *buf, size_t n); \
 _funcspecs _T *_C##_shrink(_C##_t *buf); \
 _funcspecs _C##_pos_t _C##_begin(_C##_t *buf); \
@@ -135,7 +184,9 @@ _funcspecs _T _C##_get(_C##_pos_t pos); \
 _funcspecs _T *_C##_get_ptr(_C##_pos_t pos); \
 _funcspecs void _C##_set(_C##_pos_t pos, _T val); \
 _funcspecs void _C##_remove_front(_C##_t *buf); \
-_funcspecs void _C##_remove_back(_C##_t *buf);
+_funcspecs void _C##_remove_back(_C##_t *buf); \
+_funcspecs _C##_pos_t _C##_remove_unordered(_C##_t *buf, _C##_pos_t pos); \
+_funcspecs void _C##_release_tail(_C##_t *buf, _C##_pos_t pos);
 
 #define GCL_GENERATE_RINGBUF_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
 \
@@ -173,13 +224,15 @@ _funcspecs _T *_##_C##_do_resize_shrink(struct _C *buf, size_t n) \
         begin = (size_t) (new_begin - buf->data); \
     } \
 \
-    _T *data = realloc(buf->data, (n + 1) * sizeof(_T)); \
+    _T *data = _gcl_realloc(buf->data, (buf->data_end - buf->data) * sizeof(_T), \
+                            (n + 1) * sizeof(_T)); \
 \
     if (!data) { \
         GCL_ERROR(errno, "Reallocating memory for ring buffer failed"); \
         return NULL; \
     } \
 \
+    _gcl_stats_resize(_C, n, _C##_length(buf)); \
     buf->data = data; \
     buf->data_end = data + (n + 1); \
     buf->begin = data + begin; \
@@ -202,12 +255,16 @@ _funcspecs _T *_##_C##_do_resize_grow(struct _C *buf, size_t n) \
     size_t begin = (size_t) (buf->begin - buf->data); \
     size_t end = (size_t) (buf->end - buf->data); \
 \
-    _T *data = realloc(buf->data, (n + 1) * sizeof(_T)); \
+    _T *data = _gcl_realloc(buf->data, (buf->data_end - buf->data) * sizeof(_T), \
+                            (n + 1) * sizeof(_T)); \
 \
     if (!data) { \
         GCL_ERROR(errno, "Reallocating memory for ring buffer failed"); \
         return NULL; \
     } \
+\
+    if (buf->policy && buf->policy->round_to_usable_size) \
+        n = _gcl_usable_size(data, (n + 1) * sizeof(_T)) / sizeof(_T) - 1; \
 \
     if (!_##_C##_contiguous(buf)) { \
 \
@@ -225,6 +282,7 @@ _funcspecs _T *_##_C##_do_resize_grow(struct _C *buf, size_t n) \
         } \
     } \
 \
+    _gcl_stats_resize(_C, n, _C##_length(buf)); \
     buf->data = data; \
     buf->data_end = data + (n + 1); \
     buf->begin = data + begin; \
@@ -237,11 +295,15 @@ _funcspecs _T *_##_C##_grow(struct _C *buf) \
 { \
     size_t max_cap = _C##_max_capacity(); \
     size_t old_cap = _C##_capacity(buf); \
+\
+    _gcl_stats_grow(_C); \
 \
     if (old_cap == max_cap) \
         return NULL; \
 \
-    size_t new_cap = (size_t) ((old_cap + 1) * GCL_RINGBUF_GROWTH_FACTOR) - 1; \
+    size_t new_cap = buf->policy ? \
+        gcl_growth_policy_next(buf->policy, old_cap, old_cap + 1) : \
+        (size_t) ((old_cap + 1) * GCL_RINGBUF_GROWTH_FACTOR) - 1; \
 \
     if (new_cap > max_cap) \
         new_cap = max_cap; \
@@ -249,39 +311,43 @@ _funcspecs _T *_##_C##_grow(struct _C *buf) \
     return _##_C##_do_resize_grow(buf, new_cap); \
 } \
 \
-_funcspecs _T *init__C(struct _C *buf, size_t n, void (*destroy_elem)(_T)) \
+_funcspecs _T *init_##_C(struct _C *buf, size_t n, void (*destroy_elem)(_T)) \
 { \
     if (n < GCL_RINGBUF_INITIAL_CAPACITY) \
         n = GCL_RINGBUF_INITIAL_CAPACITY; \
 \
-    _T *data = malloc((n + 1) * sizeof(_T)); \
+    _T *data = _gcl_malloc((n + 1) * sizeof(_T)); \
 \
     if (!data) { \
         GCL_ERROR(errno, "Allocating memory for ring buffer failed"); \
         return NULL; \
     } \
 \
+    _gcl_stats_alloc(_C); \
+    _gcl_stats_capacity(_C, n, 0); \
     *buf = (struct _C) { \
         .data = data, \
-        .data_end = data + n, \
+        .data_end = data + (n + 1), \
         .begin = data, \
         .end = data, \
-        .destroy_elem = destroy_elem \
+        .destroy_elem = destroy_elem, \
+        .policy = NULL \
     }; \
 \
     return data; \
 } \
 \
-_funcspecs void destroy__C(struct _C *buf) \
+_funcspecs void destroy_##_C(struct _C *buf) \
 { \
     _T *ptr; \
 \
-    if (buf->destroy_elem) { \
+    if (!_##_C##_trivial_elem(buf)) { \
         _gcl_ringbuf_for_each_ptr(ptr, buf) \
-            buf->destroy_elem(*ptr); \
+            _##_C##_destroy_elem(buf, *ptr); \
     } \
 \
-    free(buf->data); \
+    _gcl_stats_free(_C); \
+    _gcl_free(buf->data, (buf->data_end - buf->data) * sizeof(_T)); \
 } \
 \
 _funcspecs _C##_pos_t _C##_insert(_C##_t *buf, _C##_pos_t pos, _T val) \
@@ -313,6 +379,7 @@ _funcspecs _C##_pos_t _C##_insert(_C##_t *buf, _C##_pos_t pos, _T val) \
         _##_C##_ptr_dec(buf, &buf->begin); \
     } \
 \
+    _gcl_stats_length(_C, _C##_length(buf)); \
     return pos; \
 } \
 \
@@ -329,6 +396,8 @@ _funcspecs _C##_pos_t _C##_insert_front(_C##_t *buf, _T val) \
 \
     _##_C##_ptr_dec(buf, &buf->begin); \
     *buf->begin = val; \
+    assert(!_C##_empty(buf)); \
+    _gcl_stats_length(_C, _C##_length(buf)); \
     return _##_C##_pos(buf, buf->begin); \
 } \
 \
@@ -345,6 +414,8 @@ _funcspecs _C##_pos_t _C##_insert_back(_C##_t *buf, _T val) \
 \
     *buf->end = val; \
     _##_C##_ptr_inc(buf, &buf->end); \
+    assert(!_C##_empty(buf)); \
+    _gcl_stats_length(_C, _C##_length(buf)); \
     return _##_C##_pos(buf, buf->end - 1); \
 } \
 \
@@ -359,11 +430,13 @@ _funcspecs _C##_pos_t _C##_release(_C##_t *buf, _C##_pos_t pos) \
     if (shift_right) { \
         _##_C##_move_data(buf->begin, pos.ptr, buf->begin + 1); \
         _##_C##_ptr_inc(buf, &buf->begin); \
+        _##_C##_ptr_inc(buf, &pos.ptr); \
     } else { \
         _##_C##_move_data(pos.ptr + 1, buf->end, pos.ptr); \
         _##_C##_ptr_dec(buf, &buf->end); \
     } \
 \
+    _gcl_stats_capacity(_C, _C##_capacity(buf), _C##_length(buf)); \
     return pos; \
 } \
 \
@@ -371,23 +444,96 @@ _funcspecs _C##_pos_t _C##_remove(_C##_t *buf, _C##_pos_t pos) \
 { \
     assert(_##_C##_valid_pos(buf, pos) && !_C##_at_end(buf, pos)); \
 \
-    if (buf->destroy_elem) \
-        buf->destroy_elem(*pos.ptr); \
+    _##_C##_destroy_elem(buf, *pos.ptr); \
 \
-    return _C##_release(buf, pos); \
+    pos = _C##_release(buf, pos); \
+\
+    size_t n = gcl_growth_policy_shrink(buf->policy, _C##_length(buf), _C##_capacity(buf)); \
+\
+    if (n) { \
+        bool at_end = _C##_at_end(buf, pos); \
+        size_t i = at_end ? 0 : _##_C##_index_of_ptr(buf, pos.ptr); \
+        if (_##_C##_do_resize_shrink(buf, n)) \
+            pos.ptr = at_end ? buf->end : _##_C##_ptr_of_index(buf, i); \
+    } \
+\
+    return pos; \
 } \
 \
 _funcspecs void _C##_clear(_C##_t *buf) \
 { \
     _T *ptr; \
 \
-    if (buf->destroy_elem) { \
+    if (!_##_C##_trivial_elem(buf)) { \
         _gcl_ringbuf_for_each_ptr(ptr, buf) \
-            buf->destroy_elem(*ptr); \
+            _##_C##_destroy_elem(buf, *ptr); \
     } \
 \
     buf->begin = buf->data; \
     buf->end = buf->data; \
+    _gcl_stats_capacity(_C, _C##_capacity(buf), 0); \
+} \
+\
+_funcspecs void _C##_linearize(_C##_t *buf) \
+{ \
+    size_t length = _C##_length(buf); \
+\
+    if (_##_C##_contiguous(buf)) { \
+        _##_C##_move_data(buf->begin, buf->end, buf->data); \
+    } else { \
+        _##_C##_reverse_data(buf->data, buf->begin); \
+        _##_C##_reverse_data(buf->begin, buf->data_end); \
+        _##_C##_reverse_data(buf->data, buf->data_end); \
+    } \
+\
+    buf->begin = buf->data; \
+    buf->end = buf->data + length; \
+} \
+\
+_funcspecs _T *_C##_adopt_buffer(_C##_t *buf, _T *data, size_t length, size_t capacity) \
+{ \
+    assert(length <= capacity); \
+\
+    if (capacity <= length) { \
+        size_t n = length < GCL_RINGBUF_MINIMAL_CAPACITY ? GCL_RINGBUF_MINIMAL_CAPACITY : length; \
+        _T *new_data = _gcl_realloc(data, capacity * sizeof(_T), (n + 1) * sizeof(_T)); \
+        if (!new_data) { \
+            GCL_ERROR(errno, "Reallocating memory for ring buffer failed"); \
+            return NULL; \
+        } \
+        data = new_data; \
+        capacity = n + 1; \
+    } \
+\
+    destroy_##_C(buf); \
+    buf->data = data; \
+    buf->data_end = data + capacity; \
+    buf->begin = data; \
+    buf->end = data + length; \
+    _gcl_stats_length(_C, length); \
+    _gcl_stats_capacity(_C, _C##_capacity(buf), length); \
+    return data; \
+} \
+\
+_funcspecs _T *_C##_steal_buffer(_C##_t *buf, size_t *length, size_t *capacity) \
+{ \
+    _T *data = buf->data; \
+\
+    _C##_linearize(buf); \
+    *length = _C##_length(buf); \
+    *capacity = (size_t) (buf->data_end - buf->data); \
+    buf->data = NULL; \
+    buf->data_end = NULL; \
+    buf->begin = NULL; \
+    buf->end = NULL; \
+    return data; \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *buf1, _C##_t *buf2) \
+{ \
+    struct _C tmp = *buf1; \
+    *buf1 = *buf2; \
+    *buf2 = tmp; \
 }
 
 #define GCL_GENERATE_RINGBUF_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
@@ -474,13 +620,26 @@ _funcspecs bool _##_C##_contiguous(struct _C *buf) \
 _funcspecs bool _##_C##_full(struct _C *buf) \
 { \
     ptrdiff_t d = buf->end - buf->begin; \
-    return (d >= 0 && d == _C##_capacity(buf) - 1) || d == -1; \
+    return (d >= 0 && (size_t) d == _C##_capacity(buf)) || d == -1; \
 } \
 \
 _funcspecs void _##_C##_move_data(_T *begin, _T *end, _T *dest) \
 { \
-    if (begin < end) \
+    if (begin < end) { \
+        _gcl_stats_moved(_C, (end - begin) * sizeof(_T)); \
         memmove(dest, begin, (end - begin) * sizeof(_T)); \
+    } \
+} \
+\
+_funcspecs void _##_C##_reverse_data(_T *begin, _T *end) \
+{ \
+    _T tmp; \
+\
+    while (begin < end && begin < --end) { \
+        tmp = *begin; \
+        *begin++ = *end; \
+        *end = tmp; \
+    } \
 } \
 \
 _funcspecs size_t _C##_length(_C##_t *buf) \
@@ -505,6 +664,11 @@ _funcspecs size_t _C##_max_capacity(void) \
     return (size_t) (SIZE_MAX / (GCL_RINGBUF_GROWTH_FACTOR * sizeof(_T))) - 1; \
 } \
 \
+_funcspecs void _C##_set_policy(_C##_t *buf, const struct gcl_growth_policy *policy) \
+{ \
+    buf->policy = policy; \
+} \
+\
 _funcspecs _T *_C##_reserve(_C##_t *buf, size_t n) \
 { \
     assert(n <= _C##_max_capacity()); \
@@ -657,7 +821,26 @@ _funcspecs void _C##_remove_front(_C##_t *buf) \
 _funcspecs void _C##_remove_back(_C##_t *buf) \
 { \
     assert(!_C##_empty(buf)); \
-    _C##_remove(buf, _C##_end(buf)); \
+    _C##_remove(buf, _C##_prev(_C##_end(buf))); \
+} \
+\
+_funcspecs _C##_pos_t _C##_remove_unordered(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    assert(_##_C##_valid_pos(buf, pos) && !_C##_at_end(buf, pos)); \
+\
+    _##_C##_destroy_elem(buf, *pos.ptr); \
+\
+    _##_C##_ptr_dec(buf, &buf->end); \
+    *pos.ptr = *buf->end; \
+    _gcl_stats_capacity(_C, _C##_capacity(buf), _C##_length(buf)); \
+    return pos; \
+} \
+\
+_funcspecs void _C##_release_tail(_C##_t *buf, _C##_pos_t pos) \
+{ \
+    assert(_##_C##_valid_pos(buf, pos)); \
+    buf->end = pos.ptr; \
+    _gcl_stats_capacity(_C, _C##_capacity(buf), _C##_length(buf)); \
 }
 
 #endif
@@ -0,0 +1,423 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A concurrent skip list implementing an ordered set.  Any number of
+ * threads may insert and look up elements concurrently: insertion links a
+ * node level by level with CAS, and lookups and iteration never wait.
+ * Elements cannot be removed individually; they are freed together by
+ * destroy_##_C, which must not run concurrently with other operations.
+ *
+ * Nodes have variable height and are carved out of large arena chunks, so
+ * that inserting an element costs at most one malloc per chunk.  The
+ * comparison function cmp(a, b) returns a negative, zero or positive value
+ * like strcmp.
+ *
+ * Positions point to nodes and stay valid until the list is destroyed.
+ * Iteration follows the bottom level in ascending order; positions can only
+ * be moved forward.  Elements reached through _C##_get_ptr must not be
+ * modified in a way that changes their order.
+ *
+ * Requires C11 atomics.
+ */
+
+#ifndef GCL_SKIPLIST_H
+#define GCL_SKIPLIST_H
+
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef GCL_ERROR
+#define GCL_ERROR(errnum, ...)
+#endif
+
+#ifndef GCL_SKIPLIST_MAX_HEIGHT
+#define GCL_SKIPLIST_MAX_HEIGHT         (16)
+#endif
+
+#ifndef GCL_SKIPLIST_ARENA_CHUNK_SIZE
+#define GCL_SKIPLIST_ARENA_CHUNK_SIZE   (64 * 1024)
+#endif
+
+struct gcl_skiplist_chunk {
+    struct gcl_skiplist_chunk *next;
+    size_t size;
+    atomic_size_t used;
+    _Alignas(max_align_t) char data[];
+};
+
+/*
+ * Returns a height between 1 and GCL_SKIPLIST_MAX_HEIGHT with
+ * P(h) = (3/4) 4^-(h-1), the maximum height taking the remaining probability.
+ */
+static inline int _gcl_skiplist_random_height(atomic_uint_fast64_t *seed)
+{
+    uint64_t x = atomic_fetch_add_explicit(seed, UINT64_C(0x9e3779b97f4a7c15),
+                                           memory_order_relaxed);
+    int height = 1;
+
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+
+    while (height < GCL_SKIPLIST_MAX_HEIGHT && (x & 3) == 0) {
+        height++;
+        x >>= 2;
+    }
+
+    return height;
+}
+
+#define GCL_GENERATE_SKIPLIST_TYPES(_C, _T) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_node *_C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef _T _C##_elem_t; \
+\
+struct _C##_node { \
+    _T elem; \
+    int height; \
+    _Atomic(struct _C##_node *) next[]; \
+}; \
+\
+struct _C##_range { \
+    struct _C##_node *begin; \
+    struct _C##_node *end; \
+}; \
+\
+struct _C { \
+    struct _C##_node *head; \
+    atomic_int height; \
+    atomic_size_t length; \
+    atomic_uint_fast64_t seed; \
+    _Atomic(struct gcl_skiplist_chunk *) chunks; \
+    void (*destroy_elem)(_T); \
+};
+
+#define GCL_GENERATE_SKIPLIST_FUNCTIONS_STATIC(_C, _T, cmp) \
+    GCL_GENERATE_SKIPLIST_LONG_FUNCTION_DECLS(_C, _T, cmp, static) \
+    GCL_GENERATE_SKIPLIST_SHORT_FUNCTION_DECLS(_C, _T, cmp, static inline) \
+    GCL_GENERATE_SKIPLIST_LONG_FUNCTION_DEFS(_C, _T, cmp, static) \
+    GCL_GENERATE_SKIPLIST_SHORT_FUNCTION_DEFS(_C, _T, cmp, static inline)
+
+#define GCL_GENERATE_SKIPLIST_FUNCTIONS_EXTERN_H(_C, _T, cmp) \
+    GCL_GENERATE_SKIPLIST_LONG_FUNCTION_DECLS(_C, _T, cmp, ) \
+    GCL_GENERATE_SKIPLIST_SHORT_FUNCTION_DECLS(_C, _T, cmp, inline) \
+    GCL_GENERATE_SKIPLIST_SHORT_FUNCTION_DEFS(_C, _T, cmp, inline)
+
+#define GCL_GENERATE_SKIPLIST_FUNCTIONS_EXTERN_C(_C, _T, cmp) \
+    GCL_GENERATE_SKIPLIST_LONG_FUNCTION_DEFS(_C, _T, cmp, ) \
+    GCL_GENERATE_SKIPLIST_SHORT_FUNCTION_DECLS(_C, _T, cmp, )
+
+#define GCL_GENERATE_SKIPLIST_LONG_FUNCTION_DECLS(_C, _T, cmp, _funcspecs) \
+\
+_funcspecs struct _C##_node *_##_C##_new_node(struct _C *list, int height); \
+_funcspecs struct _C##_node *_##_C##_find_preds(struct _C *list, _T val, struct _C##_node **preds); \
+_funcspecs struct _C##_node *init_##_C(struct _C *list, void (*destroy_elem)(_T)); \
+_funcspecs void destroy_##_C(struct _C *list); \
+_funcspecs _C##_pos_t _C##_insert(_C##_t *list, _T val); \
+_funcspecs _C##_pos_t _C##_lower_bound(_C##_t *list, _T val); \
+_funcspecs _C##_pos_t _C##_upper_bound(_C##_t *list, _T val);
+
+#define GCL_GENERATE_SKIPLIST_SHORT_FUNCTION_DECLS(_C, _T, cmp, _funcspecs) \
+\
+_funcspecs struct _C##_node *_##_C##_next_node(struct _C##_node *node, int level); \
+_funcspecs size_t _C##_length(_C##_t *list); \
+_funcspecs bool _C##_empty(_C##_t *list); \
+_funcspecs _C##_pos_t _C##_find(_C##_t *list, _T val); \
+_funcspecs bool _C##_contains(_C##_t *list, _T val); \
+_funcspecs _C##_pos_t _C##_begin(_C##_t *list); \
+_funcspecs _C##_pos_t _C##_end(_C##_t *list); \
+_funcspecs bool _C##_at_begin(_C##_t *list, _C##_pos_t pos); \
+_funcspecs bool _C##_at_end(_C##_t *list, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos); \
+_funcspecs void _C##_forward(_C##_pos_t *pos); \
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end); \
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range); \
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range); \
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_all(_C##_t *list); \
+_funcspecs _C##_range_t _C##_range_between(_C##_t *list, _T lo, _T hi); \
+_funcspecs bool _C##_range_empty(_C##_range_t range); \
+_funcspecs _T _C##_front(_C##_t *list); \
+_funcspecs _T _C##_get(_C##_pos_t pos); \
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos);
+
+#define GCL_GENERATE_SKIPLIST_LONG_FUNCTION_DEFS(_C, _T, cmp, _funcspecs) \
+\
+_funcspecs struct _C##_node *_##_C##_new_node(struct _C *list, int height) \
+{ \
+    struct gcl_skiplist_chunk *chunk, *new_chunk; \
+    size_t size = sizeof(struct _C##_node) + height * sizeof(struct _C##_node *); \
+    size_t offset; \
+\
+    size = (size + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1); \
+\
+    for (;;) { \
+        chunk = atomic_load_explicit(&list->chunks, memory_order_acquire); \
+\
+        if (chunk) { \
+            offset = atomic_fetch_add_explicit(&chunk->used, size, memory_order_relaxed); \
+            if (offset + size <= chunk->size) \
+                break; \
+        } \
+\
+        size_t chunk_size = size > GCL_SKIPLIST_ARENA_CHUNK_SIZE ? size : GCL_SKIPLIST_ARENA_CHUNK_SIZE; \
+\
+        if (!(new_chunk = malloc(sizeof(*new_chunk) + chunk_size))) { \
+            GCL_ERROR(errno, "Allocating memory for skip list nodes failed"); \
+            return NULL; \
+        } \
+\
+        new_chunk->next = chunk; \
+        new_chunk->size = chunk_size; \
+        atomic_init(&new_chunk->used, 0); \
+\
+        if (!atomic_compare_exchange_strong_explicit(&list->chunks, &chunk, new_chunk, \
+                                                     memory_order_acq_rel, \
+                                                     memory_order_acquire)) \
+            free(new_chunk); \
+    } \
+\
+    struct _C##_node *node = (struct _C##_node *) (chunk->data + offset); \
+    int i; \
+\
+    node->height = height; \
+    for (i = 0; i < height; i++) \
+        atomic_init(&node->next[i], NULL); \
+\
+    return node; \
+} \
+\
+_funcspecs struct _C##_node *_##_C##_find_preds(struct _C *list, _T val, struct _C##_node **preds) \
+{ \
+    struct _C##_node *node = list->head, *next = NULL; \
+    int level = atomic_load_explicit(&list->height, memory_order_relaxed) - 1; \
+\
+    for (; level >= 0; level--) { \
+        while ((next = _##_C##_next_node(node, level)) && cmp(next->elem, val) < 0) \
+            node = next; \
+        if (preds) \
+            preds[level] = node; \
+    } \
+\
+    return next; \
+} \
+\
+_funcspecs struct _C##_node *init_##_C(struct _C *list, void (*destroy_elem)(_T)) \
+{ \
+    atomic_init(&list->height, 1); \
+    atomic_init(&list->length, 0); \
+    atomic_init(&list->seed, (uint_fast64_t) (uintptr_t) list); \
+    atomic_init(&list->chunks, NULL); \
+    list->destroy_elem = destroy_elem; \
+    list->head = _##_C##_new_node(list, GCL_SKIPLIST_MAX_HEIGHT); \
+    return list->head; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *list) \
+{ \
+    struct gcl_skiplist_chunk *chunk, *tmp; \
+    struct _C##_node *node; \
+\
+    if (list->destroy_elem) { \
+        for (node = _C##_begin(list); node; node = _C##_next(node)) \
+            list->destroy_elem(node->elem); \
+    } \
+\
+    for (chunk = atomic_load(&list->chunks); chunk; chunk = tmp) { \
+        tmp = chunk->next; \
+        free(chunk); \
+    } \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert(_C##_t *list, _T val) \
+{ \
+    struct _C##_node *preds[GCL_SKIPLIST_MAX_HEIGHT]; \
+    struct _C##_node *node, *succ; \
+    int height = _gcl_skiplist_random_height(&list->seed); \
+    int list_height = atomic_load_explicit(&list->height, memory_order_relaxed); \
+    int i; \
+\
+    while (height > list_height \
+           && !atomic_compare_exchange_weak_explicit(&list->height, &list_height, height, \
+                                                     memory_order_relaxed, \
+                                                     memory_order_relaxed)) \
+        ; \
+\
+    for (i = list_height; i < height; i++) \
+        preds[i] = list->head; \
+\
+    succ = _##_C##_find_preds(list, val, preds); \
+    if (succ && cmp(succ->elem, val) == 0) \
+        return succ; \
+\
+    if (!(node = _##_C##_new_node(list, height))) \
+        return NULL; \
+\
+    node->elem = val; \
+\
+    for (i = 0; i < height; i++) { \
+        for (;;) { \
+            while ((succ = _##_C##_next_node(preds[i], i)) && cmp(succ->elem, val) < 0) \
+                preds[i] = succ; \
+            if (i == 0 && succ && cmp(succ->elem, val) == 0) \
+                return succ; \
+            atomic_store_explicit(&node->next[i], succ, memory_order_relaxed); \
+            if (atomic_compare_exchange_weak_explicit(&preds[i]->next[i], &succ, node, \
+                                                      memory_order_release, \
+                                                      memory_order_relaxed)) \
+                break; \
+        } \
+    } \
+\
+    atomic_fetch_add_explicit(&list->length, 1, memory_order_relaxed); \
+    return node; \
+} \
+\
+_funcspecs _C##_pos_t _C##_lower_bound(_C##_t *list, _T val) \
+{ \
+    return _##_C##_find_preds(list, val, NULL); \
+} \
+\
+_funcspecs _C##_pos_t _C##_upper_bound(_C##_t *list, _T val) \
+{ \
+    struct _C##_node *node = _##_C##_find_preds(list, val, NULL); \
+\
+    while (node && cmp(node->elem, val) <= 0) \
+        node = _C##_next(node); \
+\
+    return node; \
+}
+
+#define GCL_GENERATE_SKIPLIST_SHORT_FUNCTION_DEFS(_C, _T, cmp, _funcspecs) \
+\
+_funcspecs struct _C##_node *_##_C##_next_node(struct _C##_node *node, int level) \
+{ \
+    return atomic_load_explicit(&node->next[level], memory_order_acquire); \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *list) \
+{ \
+    return atomic_load_explicit(&list->length, memory_order_relaxed); \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *list) \
+{ \
+    return _C##_begin(list) == NULL; \
+} \
+\
+_funcspecs _C##_pos_t _C##_find(_C##_t *list, _T val) \
+{ \
+    struct _C##_node *node = _C##_lower_bound(list, val); \
+\
+    return node && cmp(node->elem, val) == 0 ? node : NULL; \
+} \
+\
+_funcspecs bool _C##_contains(_C##_t *list, _T val) \
+{ \
+    return _C##_find(list, val) != NULL; \
+} \
+\
+_funcspecs _C##_pos_t _C##_begin(_C##_t *list) \
+{ \
+    return _##_C##_next_node(list->head, 0); \
+} \
+\
+_funcspecs _C##_pos_t _C##_end(_C##_t *list) \
+{ \
+    return NULL; \
+} \
+\
+_funcspecs bool _C##_at_begin(_C##_t *list, _C##_pos_t pos) \
+{ \
+    return pos == _C##_begin(list); \
+} \
+\
+_funcspecs bool _C##_at_end(_C##_t *list, _C##_pos_t pos) \
+{ \
+    return pos == NULL; \
+} \
+\
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos) \
+{ \
+    return _##_C##_next_node(pos, 0); \
+} \
+\
+_funcspecs void _C##_forward(_C##_pos_t *pos) \
+{ \
+    *pos = _##_C##_next_node(*pos, 0); \
+} \
+\
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end) \
+{ \
+    return (struct _C##_range) { begin, end }; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range) \
+{ \
+    return range.begin; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range) \
+{ \
+    return range.end; \
+} \
+\
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos == range.begin; \
+} \
+\
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos == range.end; \
+} \
+\
+_funcspecs _C##_range_t _C##_all(_C##_t *list) \
+{ \
+    return (struct _C##_range) { _C##_begin(list), NULL }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_between(_C##_t *list, _T lo, _T hi) \
+{ \
+    assert(cmp(lo, hi) <= 0); \
+\
+    /* Find the end first so that concurrent inserts cannot move it before the beginning. */ \
+    struct _C##_node *end = _C##_lower_bound(list, hi); \
+    return (struct _C##_range) { _C##_lower_bound(list, lo), end }; \
+} \
+\
+_funcspecs bool _C##_range_empty(_C##_range_t range) \
+{ \
+    return range.begin == range.end; \
+} \
+\
+_funcspecs _T _C##_front(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    return _C##_begin(list)->elem; \
+} \
+\
+_funcspecs _T _C##_get(_C##_pos_t pos) \
+{ \
+    return pos->elem; \
+} \
+\
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos) \
+{ \
+    return &pos->elem; \
+}
+
+#endif
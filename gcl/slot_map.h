@@ -0,0 +1,402 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A slot map stores its elements densely in a vector and hands out
+ * generational handles that stay valid until the element is removed.
+ * Insertion and removal are O(1); removal moves the last element into the
+ * gap, so positions (but not handles) are invalidated.  A handle of a
+ * removed element never becomes valid again, even if its slot is reused,
+ * until the slot's 32-bit generation counter wraps around.
+ *
+ * Iteration runs over the dense array through the usual position and range
+ * functions.  _C##_handle_of maps a position back to the element's handle.
+ */
+
+#ifndef GCL_SLOT_MAP_H
+#define GCL_SLOT_MAP_H
+
+#include "vector.h"
+
+#define GCL_SLOT_MAP_NO_SLOT            UINT32_MAX
+
+struct gcl_slot {
+    uint32_t index;
+    uint32_t generation;
+};
+
+struct gcl_slot_handle {
+    uint32_t index;
+    uint32_t generation;
+};
+
+#define GCL_SLOT_HANDLE_NULL            ((struct gcl_slot_handle) { 0, 0 })
+
+/* Slots with an odd generation are occupied. */
+#define _gcl_slot_occupied(slot)        ((slot)->generation & 1)
+
+#define GCL_GENERATE_SLOT_MAP_TYPES(_C, _T) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_values, _T) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_owners, uint32_t) \
+    GCL_GENERATE_VECTOR_TYPES(_C##_slots, struct gcl_slot) \
+\
+typedef struct _C _C##_t; \
+typedef struct gcl_slot_handle _C##_handle_t; \
+typedef _T *_C##_pos_t; \
+typedef struct _C##_values_range _C##_range_t; \
+typedef _T _C##_elem_t; \
+\
+struct _C { \
+    struct _C##_values values; \
+    struct _C##_owners owners; \
+    struct _C##_slots slots; \
+    uint32_t free_head; \
+};
+
+#define GCL_GENERATE_SLOT_MAP_FUNCTIONS_STATIC(_C, _T) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_values, _T) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_owners, uint32_t) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C##_slots, struct gcl_slot) \
+    GCL_GENERATE_SLOT_MAP_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_SLOT_MAP_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_SLOT_MAP_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_SLOT_MAP_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_SLOT_MAP_FUNCTIONS_EXTERN_H(_C, _T) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_values, _T) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_owners, uint32_t) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C##_slots, struct gcl_slot) \
+    GCL_GENERATE_SLOT_MAP_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_SLOT_MAP_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_SLOT_MAP_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_SLOT_MAP_FUNCTIONS_EXTERN_C(_C, _T) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_values, _T) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_owners, uint32_t) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C##_slots, struct gcl_slot) \
+    GCL_GENERATE_SLOT_MAP_LONG_FUNCTION_DEFS(_C, _T, ) \
+    GCL_GENERATE_SLOT_MAP_SHORT_FUNCTION_DECLS(_C, _T, )
+
+#define GCL_GENERATE_SLOT_MAP_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *map, size_t n, void (*destroy_elem)(_T)); \
+_funcspecs void destroy_##_C(struct _C *map); \
+_funcspecs _C##_handle_t _C##_insert(_C##_t *map, _T val); \
+_funcspecs bool _C##_release(_C##_t *map, _C##_handle_t handle); \
+_funcspecs bool _C##_remove(_C##_t *map, _C##_handle_t handle); \
+_funcspecs void _C##_clear(_C##_t *map); \
+_funcspecs void _C##_swap(_C##_t *map1, _C##_t *map2);
+
+#define GCL_GENERATE_SLOT_MAP_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs struct gcl_slot *_##_C##_slot(struct _C *map, _C##_handle_t handle); \
+_funcspecs void _##_C##_free_slot(struct _C *map, uint32_t i); \
+_funcspecs size_t _C##_length(_C##_t *map); \
+_funcspecs bool _C##_empty(_C##_t *map); \
+_funcspecs bool _C##_contains(_C##_t *map, _C##_handle_t handle); \
+_funcspecs _T *_C##_lookup(_C##_t *map, _C##_handle_t handle); \
+_funcspecs _C##_pos_t _C##_pos_of(_C##_t *map, _C##_handle_t handle); \
+_funcspecs _C##_handle_t _C##_handle_of(_C##_t *map, _C##_pos_t pos); \
+_funcspecs bool _C##_handle_null(_C##_handle_t handle); \
+_funcspecs _C##_pos_t _C##_begin(_C##_t *map); \
+_funcspecs _C##_pos_t _C##_end(_C##_t *map); \
+_funcspecs bool _C##_at_begin(_C##_t *map, _C##_pos_t pos); \
+_funcspecs bool _C##_at_end(_C##_t *map, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos); \
+_funcspecs void _C##_forward(_C##_pos_t *pos); \
+_funcspecs void _C##_backward(_C##_pos_t *pos); \
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end); \
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range); \
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range); \
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_all(_C##_t *map); \
+_funcspecs bool _C##_range_empty(_C##_range_t range); \
+_funcspecs _T _C##_get(_C##_pos_t pos); \
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos); \
+_funcspecs void _C##_set(_C##_pos_t pos, _T val);
+
+#define GCL_GENERATE_SLOT_MAP_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs bool init_##_C(struct _C *map, size_t n, void (*destroy_elem)(_T)) \
+{ \
+    map->free_head = GCL_SLOT_MAP_NO_SLOT; \
+\
+    if (!init_##_C##_values(&map->values, n, destroy_elem)) \
+        return false; \
+\
+    if (!init_##_C##_owners(&map->owners, n, NULL)) { \
+        destroy_##_C##_values(&map->values); \
+        return false; \
+    } \
+\
+    if (!init_##_C##_slots(&map->slots, n, NULL)) { \
+        destroy_##_C##_owners(&map->owners); \
+        destroy_##_C##_values(&map->values); \
+        return false; \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *map) \
+{ \
+    destroy_##_C##_values(&map->values); \
+    destroy_##_C##_owners(&map->owners); \
+    destroy_##_C##_slots(&map->slots); \
+} \
+\
+_funcspecs _C##_handle_t _C##_insert(_C##_t *map, _T val) \
+{ \
+    size_t length = _gcl_vector_length(&map->values); \
+    struct gcl_slot *slot; \
+    uint32_t i; \
+\
+    if (map->free_head != GCL_SLOT_MAP_NO_SLOT) { \
+        i = map->free_head; \
+        map->free_head = map->slots.data[i].index; \
+    } else { \
+        i = (uint32_t) _gcl_vector_length(&map->slots); \
+        if (i == GCL_SLOT_MAP_NO_SLOT) { \
+            GCL_ERROR(ENOMEM, "Slot map is full"); \
+            return GCL_SLOT_HANDLE_NULL; \
+        } \
+        if (!_C##_slots_insert_back(&map->slots, (struct gcl_slot) { 0, 0 })) \
+            return GCL_SLOT_HANDLE_NULL; \
+    } \
+\
+    if (!_C##_values_insert_back(&map->values, val)) { \
+        _##_C##_free_slot(map, i); \
+        return GCL_SLOT_HANDLE_NULL; \
+    } \
+\
+    if (!_C##_owners_insert_back(&map->owners, i)) { \
+        _C##_values_release(&map->values, map->values.end - 1); \
+        _##_C##_free_slot(map, i); \
+        return GCL_SLOT_HANDLE_NULL; \
+    } \
+\
+    slot = &map->slots.data[i]; \
+    slot->index = (uint32_t) length; \
+    slot->generation++; \
+    return (struct gcl_slot_handle) { i, slot->generation }; \
+} \
+\
+_funcspecs bool _C##_release(_C##_t *map, _C##_handle_t handle) \
+{ \
+    struct gcl_slot *slot = _##_C##_slot(map, handle); \
+    size_t last = _gcl_vector_length(&map->values) - 1; \
+    uint32_t i; \
+\
+    if (!slot) \
+        return false; \
+\
+    i = slot->index; \
+\
+    if (i != last) { \
+        map->values.data[i] = map->values.data[last]; \
+        map->owners.data[i] = map->owners.data[last]; \
+        map->slots.data[map->owners.data[i]].index = i; \
+    } \
+\
+    _C##_values_release(&map->values, map->values.end - 1); \
+    _C##_owners_release(&map->owners, map->owners.end - 1); \
+\
+    slot->generation++; \
+    _##_C##_free_slot(map, handle.index); \
+    return true; \
+} \
+\
+_funcspecs bool _C##_remove(_C##_t *map, _C##_handle_t handle) \
+{ \
+    struct gcl_slot *slot = _##_C##_slot(map, handle); \
+\
+    if (!slot) \
+        return false; \
+\
+    if (map->values.destroy_elem) \
+        map->values.destroy_elem(map->values.data[slot->index]); \
+\
+    return _C##_release(map, handle); \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *map) \
+{ \
+    uint32_t *owner; \
+\
+    _gcl_vector_for_each_pos(owner, &map->owners) { \
+        map->slots.data[*owner].generation++; \
+        _##_C##_free_slot(map, *owner); \
+    } \
+\
+    _C##_values_clear(&map->values); \
+    _C##_owners_clear(&map->owners); \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *map1, _C##_t *map2) \
+{ \
+    struct _C tmp = *map1; \
+    *map1 = *map2; \
+    *map2 = tmp; \
+}
+
+#define GCL_GENERATE_SLOT_MAP_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs struct gcl_slot *_##_C##_slot(struct _C *map, _C##_handle_t handle) \
+{ \
+    struct gcl_slot *slot; \
+\
+    if (handle.index >= _gcl_vector_length(&map->slots)) \
+        return NULL; \
+\
+    slot = &map->slots.data[handle.index]; \
+\
+    if (!_gcl_slot_occupied(slot) || slot->generation != handle.generation) \
+        return NULL; \
+\
+    return slot; \
+} \
+\
+_funcspecs void _##_C##_free_slot(struct _C *map, uint32_t i) \
+{ \
+    map->slots.data[i].index = map->free_head; \
+    map->free_head = i; \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *map) \
+{ \
+    return _gcl_vector_length(&map->values); \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *map) \
+{ \
+    return _C##_values_empty(&map->values); \
+} \
+\
+_funcspecs bool _C##_contains(_C##_t *map, _C##_handle_t handle) \
+{ \
+    return _##_C##_slot(map, handle) != NULL; \
+} \
+\
+_funcspecs _T *_C##_lookup(_C##_t *map, _C##_handle_t handle) \
+{ \
+    struct gcl_slot *slot = _##_C##_slot(map, handle); \
+\
+    return slot ? &map->values.data[slot->index] : NULL; \
+} \
+\
+_funcspecs _C##_pos_t _C##_pos_of(_C##_t *map, _C##_handle_t handle) \
+{ \
+    struct gcl_slot *slot = _##_C##_slot(map, handle); \
+\
+    return slot ? &map->values.data[slot->index] : _C##_end(map); \
+} \
+\
+_funcspecs _C##_handle_t _C##_handle_of(_C##_t *map, _C##_pos_t pos) \
+{ \
+    uint32_t i = map->owners.data[pos - map->values.data]; \
+\
+    return (struct gcl_slot_handle) { i, map->slots.data[i].generation }; \
+} \
+\
+_funcspecs bool _C##_handle_null(_C##_handle_t handle) \
+{ \
+    return handle.generation == 0; \
+} \
+\
+_funcspecs _C##_pos_t _C##_begin(_C##_t *map) \
+{ \
+    return _C##_values_begin(&map->values); \
+} \
+\
+_funcspecs _C##_pos_t _C##_end(_C##_t *map) \
+{ \
+    return _C##_values_end(&map->values); \
+} \
+\
+_funcspecs bool _C##_at_begin(_C##_t *map, _C##_pos_t pos) \
+{ \
+    return _C##_values_at_begin(&map->values, pos); \
+} \
+\
+_funcspecs bool _C##_at_end(_C##_t *map, _C##_pos_t pos) \
+{ \
+    return _C##_values_at_end(&map->values, pos); \
+} \
+\
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos) \
+{ \
+    return _C##_values_next(pos); \
+} \
+\
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos) \
+{ \
+    return _C##_values_prev(pos); \
+} \
+\
+_funcspecs void _C##_forward(_C##_pos_t *pos) \
+{ \
+    _C##_values_forward(pos); \
+} \
+\
+_funcspecs void _C##_backward(_C##_pos_t *pos) \
+{ \
+    _C##_values_backward(pos); \
+} \
+\
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end) \
+{ \
+    return _C##_values_range(begin, end); \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range) \
+{ \
+    return range.begin; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range) \
+{ \
+    return range.end; \
+} \
+\
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos == range.begin; \
+} \
+\
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos == range.end; \
+} \
+\
+_funcspecs _C##_range_t _C##_all(_C##_t *map) \
+{ \
+    return _C##_values_all(&map->values); \
+} \
+\
+_funcspecs bool _C##_range_empty(_C##_range_t range) \
+{ \
+    return range.begin == range.end; \
+} \
+\
+_funcspecs _T _C##_get(_C##_pos_t pos) \
+{ \
+    return *pos; \
+} \
+\
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos) \
+{ \
+    return pos; \
+} \
+\
+_funcspecs void _C##_set(_C##_pos_t pos, _T val) \
+{ \
+    *pos = val; \
+}
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A small vector stores up to N elements inline in the container struct and
+ * moves them to the heap only when it grows beyond N.  Apart from init and
+ * the storage management it shares all functions with vector.h.
+ *
+ * As long as the elements are stored inline, the data pointers point into
+ * the struct itself; a small vector must therefore not be copied by
+ * assignment.  _C##_swap exchanges the inline elements, so it costs O(N)
+ * instead of O(1) while either vector is small.
+ */
+
+#ifndef GCL_SMALL_VECTOR_H
+#define GCL_SMALL_VECTOR_H
+
+#include "vector.h"
+
+#define _gcl_small_vector_small_capacity(vec) \
+    (sizeof((vec)->small_data) / sizeof(*(vec)->small_data))
+
+#define _gcl_small_vector_is_small(vec) \
+    ((vec)->data == (vec)->small_data)
+
+#define GCL_GENERATE_SMALL_VECTOR_TYPES(_C, _T, N) \
+\
+typedef struct _C _C##_t; \
+typedef _T *_C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef _T _C##_elem_t; \
+\
+struct _C##_range { \
+    _T *begin; \
+    _T *end; \
+}; \
+\
+struct _C { \
+    _T *data; \
+    _T *data_end; \
+    _T *end; \
+    void (*destroy_elem)(_T); \
+    const struct gcl_growth_policy *policy; \
+    _T small_data[N]; \
+};
+
+#define GCL_GENERATE_SMALL_VECTOR_FUNCTIONS_STATIC(_C, _T) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, static inline) \
+    GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_SMALL_VECTOR_FUNCTIONS_EXTERN_H(_C, _T) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, inline) \
+    GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_SMALL_VECTOR_FUNCTIONS_EXTERN_C(_C, _T) \
+    _gcl_stats_define_extern(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DEFS(_C, _T, ) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, )
+
+#define GCL_GENERATE_SMALL_VECTOR_FUNCTIONS_STATIC_EX(_C, _T, traits) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, static inline) \
+    GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_SMALL_VECTOR_FUNCTIONS_EXTERN_H_EX(_C, _T, traits) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, inline) \
+    GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_SMALL_VECTOR_FUNCTIONS_EXTERN_C_EX(_C, _T, traits) \
+    GCL_GENERATE_SMALL_VECTOR_FUNCTIONS_EXTERN_C(_C, _T)
+
+#define GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_SMALL_VECTOR_ALLOC_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DECLS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_SMALL_VECTOR_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_SMALL_VECTOR_ALLOC_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DEFS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_SMALL_VECTOR_ALLOC_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_ALLOC_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs void _##_C##_fix_small_data(struct _C *vec, struct _C *old); \
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2);
+
+#define GCL_GENERATE_SMALL_VECTOR_ALLOC_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *_##_C##_do_resize(struct _C *vec, size_t n) \
+{ \
+    assert(n >= _gcl_vector_length(vec) && n <= _C##_max_capacity()); \
+\
+    size_t length = _gcl_vector_length(vec); \
+    _T *data; \
+\
+    if (n <= _gcl_small_vector_small_capacity(vec)) { \
+        if (!_gcl_small_vector_is_small(vec)) { \
+            memcpy(vec->small_data, vec->data, length * sizeof(_T)); \
+            _gcl_free(vec->data, _gcl_vector_capacity(vec) * sizeof(_T)); \
+            vec->data = vec->small_data; \
+            vec->data_end = vec->small_data + _gcl_small_vector_small_capacity(vec); \
+            vec->end = vec->small_data + length; \
+        } \
+        return vec->data; \
+    } \
+\
+    if (n < GCL_VECTOR_MINIMAL_CAPACITY) \
+        n = GCL_VECTOR_MINIMAL_CAPACITY; \
+\
+    if (n == _gcl_vector_capacity(vec)) \
+        return vec->data; \
+\
+    if (_gcl_small_vector_is_small(vec)) { \
+        if (!(data = _gcl_malloc(n * sizeof(_T)))) { \
+            GCL_ERROR(errno, "Allocating memory for vector failed"); \
+            return NULL; \
+        } \
+        memcpy(data, vec->small_data, length * sizeof(_T)); \
+    } else if (!(data = _gcl_realloc(vec->data, _gcl_vector_capacity(vec) * sizeof(_T), \
+                                     n * sizeof(_T)))) { \
+        GCL_ERROR(errno, "Reallocating memory for vector failed"); \
+        return NULL; \
+    } \
+\
+    _gcl_stats_resize(_C, n, length); \
+    vec->data = data; \
+    vec->data_end = data + n; \
+    vec->end = data + length; \
+    return data; \
+} \
+\
+_funcspecs _T *init_##_C(struct _C *vec, size_t n, void (*destroy_elem)(_T)) \
+{ \
+    vec->data = vec->small_data; \
+    vec->data_end = vec->small_data + _gcl_small_vector_small_capacity(vec); \
+    vec->end = vec->small_data; \
+    vec->destroy_elem = destroy_elem; \
+    vec->policy = NULL; \
+\
+    if (n > _gcl_small_vector_small_capacity(vec)) \
+        return _##_C##_do_resize(vec, n); \
+\
+    _gcl_stats_capacity(_C, _gcl_small_vector_small_capacity(vec), 0); \
+    return vec->data; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *vec) \
+{ \
+    _T *pos; \
+\
+    if (!_##_C##_trivial_elem(vec)) { \
+        _gcl_vector_for_each_pos(pos, vec) \
+            _##_C##_destroy_elem(vec, *pos); \
+    } \
+\
+    if (!_gcl_small_vector_is_small(vec)) \
+        _gcl_free(vec->data, _gcl_vector_capacity(vec) * sizeof(_T)); \
+} \
+\
+_funcspecs void _##_C##_fix_small_data(struct _C *vec, struct _C *old) \
+{ \
+    if (vec->data == old->small_data) { \
+        vec->end = vec->small_data + (vec->end - vec->data); \
+        vec->data = vec->small_data; \
+        vec->data_end = vec->small_data + _gcl_small_vector_small_capacity(vec); \
+    } \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2) \
+{ \
+    struct _C tmp = *vec1; \
+    *vec1 = *vec2; \
+    *vec2 = tmp; \
+    _##_C##_fix_small_data(vec1, vec2); \
+    _##_C##_fix_small_data(vec2, vec1); \
+}
+
+#endif
@@ -0,0 +1,553 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A structure-of-arrays vector stores each field of its records in a
+ * separate column array.  The fields are given as (type, name) pairs:
+ *
+ *     GCL_GENERATE_SOA_VECTOR_TYPES(recs, (int, id), (double, score))
+ *     GCL_GENERATE_SOA_VECTOR_FUNCTIONS_STATIC(recs, (int, id), (double, score))
+ *
+ * Elements are whole records (struct recs_rec); positions are indices, so
+ * the alg.h macros work on records, while recs_id_span and
+ * recs_score_span give direct access to single columns.  All columns share
+ * length and capacity and are resized together.  At most 16 fields are
+ * supported.
+ */
+
+#ifndef GCL_SOA_VECTOR_H
+#define GCL_SOA_VECTOR_H
+
+#include "vector.h"
+
+#define _GCL_PP_CAT(a, b)               _GCL_PP_CAT_(a, b)
+#define _GCL_PP_CAT_(a, b)              a##b
+#define _GCL_PP_UNPACK(...)             __VA_ARGS__
+#define _GCL_PP_INVOKE(m, args)         m args
+
+#define _GCL_PP_NARGS(...) \
+    _GCL_PP_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define _GCL_PP_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+
+#define _GCL_PP_MAP(m, ctx, ...) \
+    _GCL_PP_CAT(_GCL_PP_MAP_, _GCL_PP_NARGS(__VA_ARGS__))(m, ctx, __VA_ARGS__)
+
+#define _GCL_PP_MAP_1(m, ctx, x)        _GCL_PP_INVOKE(m, (_GCL_PP_UNPACK ctx, _GCL_PP_UNPACK x))
+#define _GCL_PP_MAP_2(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_1(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_3(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_2(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_4(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_3(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_5(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_4(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_6(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_5(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_7(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_6(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_8(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_7(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_9(m, ctx, x, ...)   _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_8(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_10(m, ctx, x, ...)  _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_9(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_11(m, ctx, x, ...)  _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_10(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_12(m, ctx, x, ...)  _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_11(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_13(m, ctx, x, ...)  _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_12(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_14(m, ctx, x, ...)  _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_13(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_15(m, ctx, x, ...)  _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_14(m, ctx, __VA_ARGS__)
+#define _GCL_PP_MAP_16(m, ctx, x, ...)  _GCL_PP_MAP_1(m, ctx, x) _GCL_PP_MAP_15(m, ctx, __VA_ARGS__)
+
+#define _gcl_soa_rec_member(_C, _F, name)       _F name;
+#define _gcl_soa_col_member(_C, _F, name)       _F *name;
+
+#define _gcl_soa_span_type(_C, _F, name) \
+typedef struct _C##_##name##_span { \
+    _F *begin; \
+    _F *end; \
+} _C##_##name##_span_t;
+
+#define _gcl_soa_span_decl(_funcspecs, _C, _F, name) \
+_funcspecs _C##_##name##_span_t _C##_##name##_span(_C##_t *vec);
+
+#define _gcl_soa_span_def(_funcspecs, _C, _F, name) \
+_funcspecs _C##_##name##_span_t _C##_##name##_span(_C##_t *vec) \
+{ \
+    return (_C##_##name##_span_t) { vec->cols.name, vec->cols.name + vec->length }; \
+}
+
+#define _gcl_soa_resize_col(_C, _F, name) \
+    if (ok) { \
+        void *col = _gcl_realloc(vec->cols.name, vec->capacity * sizeof(_F), n * sizeof(_F)); \
+        if (col) { \
+            vec->cols.name = col; \
+            done++; \
+        } else { \
+            ok = false; \
+        } \
+    }
+
+#define _gcl_soa_restore_col(_C, _F, name) \
+    if (done) { \
+        void *col = _gcl_realloc(vec->cols.name, n * sizeof(_F), vec->capacity * sizeof(_F)); \
+        if (col) \
+            vec->cols.name = col; \
+        done--; \
+    }
+
+#define _gcl_soa_free_col(_C, _F, name) \
+    _gcl_free(vec->cols.name, vec->capacity * sizeof(_F));
+
+#define _gcl_soa_move_col(_C, _F, name) \
+    if (begin < end) \
+        memmove(vec->cols.name + dest, vec->cols.name + begin, (end - begin) * sizeof(_F));
+
+#define _gcl_soa_get_col(_C, _F, name)          rec.name = vec->cols.name[i];
+#define _gcl_soa_set_col(_C, _F, name)          vec->cols.name[i] = rec.name;
+
+#define GCL_GENERATE_SOA_VECTOR_TYPES(_C, ...) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_pos _C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef struct _C##_rec _C##_rec_t; \
+typedef struct _C##_rec _C##_elem_t; \
+\
+struct _C##_rec { \
+    _GCL_PP_MAP(_gcl_soa_rec_member, (_C), __VA_ARGS__) \
+}; \
+\
+struct _C##_pos { \
+    struct _C *vec; \
+    size_t i; \
+}; \
+\
+struct _C##_range { \
+    struct _C *vec; \
+    size_t begin; \
+    size_t end; \
+}; \
+\
+struct _C { \
+    size_t length; \
+    size_t capacity; \
+    struct { \
+        _GCL_PP_MAP(_gcl_soa_col_member, (_C), __VA_ARGS__) \
+    } cols; \
+    void (*destroy_elem)(struct _C##_rec); \
+}; \
+\
+_GCL_PP_MAP(_gcl_soa_span_type, (_C), __VA_ARGS__)
+
+#define GCL_GENERATE_SOA_VECTOR_FUNCTIONS_STATIC(_C, ...) \
+    GCL_GENERATE_SOA_VECTOR_LONG_FUNCTION_DECLS(_C, static, __VA_ARGS__) \
+    GCL_GENERATE_SOA_VECTOR_SHORT_FUNCTION_DECLS(_C, static inline, __VA_ARGS__) \
+    GCL_GENERATE_SOA_VECTOR_LONG_FUNCTION_DEFS(_C, static, __VA_ARGS__) \
+    GCL_GENERATE_SOA_VECTOR_SHORT_FUNCTION_DEFS(_C, static inline, __VA_ARGS__)
+
+#define GCL_GENERATE_SOA_VECTOR_FUNCTIONS_EXTERN_H(_C, ...) \
+    GCL_GENERATE_SOA_VECTOR_LONG_FUNCTION_DECLS(_C, , __VA_ARGS__) \
+    GCL_GENERATE_SOA_VECTOR_SHORT_FUNCTION_DECLS(_C, inline, __VA_ARGS__) \
+    GCL_GENERATE_SOA_VECTOR_SHORT_FUNCTION_DEFS(_C, inline, __VA_ARGS__)
+
+#define GCL_GENERATE_SOA_VECTOR_FUNCTIONS_EXTERN_C(_C, ...) \
+    GCL_GENERATE_SOA_VECTOR_LONG_FUNCTION_DEFS(_C, , __VA_ARGS__) \
+    GCL_GENERATE_SOA_VECTOR_SHORT_FUNCTION_DECLS(_C, , __VA_ARGS__)
+
+#define GCL_GENERATE_SOA_VECTOR_LONG_FUNCTION_DECLS(_C, _funcspecs, ...) \
+\
+_funcspecs bool _##_C##_do_resize(struct _C *vec, size_t n); \
+_funcspecs bool _##_C##_grow(struct _C *vec, size_t n); \
+_funcspecs bool init_##_C(struct _C *vec, size_t n, void (*destroy_elem)(struct _C##_rec)); \
+_funcspecs void destroy_##_C(struct _C *vec); \
+_funcspecs _C##_pos_t _C##_insert(_C##_t *vec, _C##_pos_t pos, struct _C##_rec rec); \
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *vec, struct _C##_rec rec); \
+_funcspecs _C##_pos_t _C##_release(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_remove(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs void _C##_clear(_C##_t *vec); \
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2);
+
+#define GCL_GENERATE_SOA_VECTOR_SHORT_FUNCTION_DECLS(_C, _funcspecs, ...) \
+\
+_funcspecs _C##_pos_t _##_C##_pos(struct _C *vec, size_t i); \
+_funcspecs _C##_range_t _##_C##_range(struct _C *vec, size_t begin, size_t end); \
+_funcspecs void _##_C##_move_data(struct _C *vec, size_t begin, size_t end, size_t dest); \
+_funcspecs size_t _C##_length(_C##_t *vec); \
+_funcspecs bool _C##_empty(_C##_t *vec); \
+_funcspecs size_t _C##_capacity(_C##_t *vec); \
+_funcspecs size_t _C##_max_capacity(void); \
+_funcspecs bool _C##_reserve(_C##_t *vec, size_t n); \
+_funcspecs bool _C##_shrink(_C##_t *vec); \
+_funcspecs _C##_pos_t _C##_begin(_C##_t *vec); \
+_funcspecs _C##_pos_t _C##_end(_C##_t *vec); \
+_funcspecs bool _C##_at_begin(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs bool _C##_at_end(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos); \
+_funcspecs void _C##_forward(_C##_pos_t *pos); \
+_funcspecs void _C##_backward(_C##_pos_t *pos); \
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end); \
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range); \
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range); \
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_all(_C##_t *vec); \
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs size_t _C##_range_length(_C##_range_t range); \
+_funcspecs bool _C##_range_empty(_C##_range_t range); \
+_funcspecs struct _C##_rec _C##_front(_C##_t *vec); \
+_funcspecs struct _C##_rec _C##_back(_C##_t *vec); \
+_funcspecs struct _C##_rec _C##_at(_C##_t *vec, size_t i); \
+_funcspecs struct _C##_rec _C##_get(_C##_pos_t pos); \
+_funcspecs void _C##_set(_C##_pos_t pos, struct _C##_rec rec); \
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *vec, struct _C##_rec rec); \
+_funcspecs void _C##_remove_front(_C##_t *vec); \
+_funcspecs void _C##_remove_back(_C##_t *vec); \
+_GCL_PP_MAP(_gcl_soa_span_decl, (_funcspecs, _C), __VA_ARGS__)
+
+#define GCL_GENERATE_SOA_VECTOR_LONG_FUNCTION_DEFS(_C, _funcspecs, ...) \
+\
+_funcspecs bool _##_C##_do_resize(struct _C *vec, size_t n) \
+{ \
+    assert(n >= vec->length && n <= _C##_max_capacity()); \
+\
+    size_t done = 0; \
+    bool ok = true; \
+\
+    if (n < GCL_VECTOR_MINIMAL_CAPACITY) \
+        n = GCL_VECTOR_MINIMAL_CAPACITY; \
+\
+    if (n == vec->capacity) \
+        return true; \
+\
+    _GCL_PP_MAP(_gcl_soa_resize_col, (_C), __VA_ARGS__) \
+\
+    if (!ok) { \
+        _GCL_PP_MAP(_gcl_soa_restore_col, (_C), __VA_ARGS__) \
+        GCL_ERROR(errno, "Reallocating memory for vector failed"); \
+        return false; \
+    } \
+\
+    vec->capacity = n; \
+    return true; \
+} \
+\
+_funcspecs bool _##_C##_grow(struct _C *vec, size_t n) \
+{ \
+    assert(n > vec->length); \
+\
+    size_t max_cap = _C##_max_capacity(); \
+    size_t new_cap; \
+\
+    if (n > max_cap) \
+        return false; \
+\
+    new_cap = (size_t) (vec->capacity * GCL_VECTOR_GROWTH_FACTOR); \
+\
+    if (new_cap > max_cap) \
+        new_cap = max_cap; \
+\
+    if (new_cap < n) \
+        new_cap = n; \
+\
+    return _##_C##_do_resize(vec, new_cap); \
+} \
+\
+_funcspecs bool init_##_C(struct _C *vec, size_t n, void (*destroy_elem)(struct _C##_rec)) \
+{ \
+    if (n < GCL_VECTOR_INITIAL_CAPACITY) \
+        n = GCL_VECTOR_INITIAL_CAPACITY; \
+\
+    memset(vec, 0, sizeof(*vec)); \
+    vec->destroy_elem = destroy_elem; \
+\
+    if (!_##_C##_do_resize(vec, n)) { \
+        GCL_ERROR(errno, "Allocating memory for vector failed"); \
+        return false; \
+    } \
+\
+    return true; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *vec) \
+{ \
+    size_t i; \
+\
+    if (vec->destroy_elem) { \
+        for (i = 0; i < vec->length; i++) \
+            vec->destroy_elem(_C##_at(vec, i)); \
+    } \
+\
+    _GCL_PP_MAP(_gcl_soa_free_col, (_C), __VA_ARGS__) \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert(_C##_t *vec, _C##_pos_t pos, struct _C##_rec rec) \
+{ \
+    assert(pos.vec == vec && pos.i <= vec->length); \
+\
+    if (vec->capacity <= vec->length) { \
+        if (!_##_C##_grow(vec, vec->length + 1)) { \
+            GCL_ERROR(0, "Increasing vector capacity failed"); \
+            return _##_C##_pos(vec, SIZE_MAX); \
+        } \
+    } \
+\
+    assert(vec->capacity > vec->length); \
+\
+    _##_C##_move_data(vec, pos.i, vec->length, pos.i + 1); \
+    vec->length++; \
+    _C##_set(pos, rec); \
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *vec, struct _C##_rec rec) \
+{ \
+    if (vec->capacity <= vec->length) { \
+        if (!_##_C##_grow(vec, vec->length + 1)) { \
+            GCL_ERROR(0, "Increasing vector capacity failed"); \
+            return _##_C##_pos(vec, SIZE_MAX); \
+        } \
+    } \
+\
+    assert(vec->capacity > vec->length); \
+\
+    _C##_set(_##_C##_pos(vec, vec->length), rec); \
+    return _##_C##_pos(vec, vec->length++); \
+} \
+\
+_funcspecs _C##_pos_t _C##_release(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    assert(pos.vec == vec && pos.i < vec->length); \
+\
+    _##_C##_move_data(vec, pos.i + 1, vec->length, pos.i); \
+    vec->length--; \
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_remove(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    assert(pos.vec == vec && pos.i < vec->length); \
+\
+    if (vec->destroy_elem) \
+        vec->destroy_elem(_C##_get(pos)); \
+\
+    return _C##_release(vec, pos); \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *vec) \
+{ \
+    size_t i; \
+\
+    if (vec->destroy_elem) { \
+        for (i = 0; i < vec->length; i++) \
+            vec->destroy_elem(_C##_at(vec, i)); \
+    } \
+\
+    vec->length = 0; \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2) \
+{ \
+    struct _C tmp = *vec1; \
+    *vec1 = *vec2; \
+    *vec2 = tmp; \
+}
+
+#define GCL_GENERATE_SOA_VECTOR_SHORT_FUNCTION_DEFS(_C, _funcspecs, ...) \
+\
+_funcspecs _C##_pos_t _##_C##_pos(struct _C *vec, size_t i) \
+{ \
+    return (struct _C##_pos) { .vec = vec, .i = i }; \
+} \
+\
+_funcspecs _C##_range_t _##_C##_range(struct _C *vec, size_t begin, size_t end) \
+{ \
+    return (struct _C##_range) { .vec = vec, .begin = begin, .end = end }; \
+} \
+\
+_funcspecs void _##_C##_move_data(struct _C *vec, size_t begin, size_t end, size_t dest) \
+{ \
+    _GCL_PP_MAP(_gcl_soa_move_col, (_C), __VA_ARGS__) \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *vec) \
+{ \
+    return vec->length; \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *vec) \
+{ \
+    return vec->length == 0; \
+} \
+\
+_funcspecs size_t _C##_capacity(_C##_t *vec) \
+{ \
+    return vec->capacity; \
+} \
+\
+_funcspecs size_t _C##_max_capacity(void) \
+{ \
+    return (size_t) (SIZE_MAX / (GCL_VECTOR_GROWTH_FACTOR * sizeof(struct _C##_rec))); \
+} \
+\
+_funcspecs bool _C##_reserve(_C##_t *vec, size_t n) \
+{ \
+    assert(n <= _C##_max_capacity()); \
+\
+    if (n > vec->capacity) \
+        return _##_C##_do_resize(vec, n); \
+    else \
+        return true; \
+} \
+\
+_funcspecs bool _C##_shrink(_C##_t *vec) \
+{ \
+    return _##_C##_do_resize(vec, vec->length); \
+} \
+\
+_funcspecs _C##_pos_t _C##_begin(_C##_t *vec) \
+{ \
+    return _##_C##_pos(vec, 0); \
+} \
+\
+_funcspecs _C##_pos_t _C##_end(_C##_t *vec) \
+{ \
+    return _##_C##_pos(vec, vec->length); \
+} \
+\
+_funcspecs bool _C##_at_begin(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return pos.i == 0; \
+} \
+\
+_funcspecs bool _C##_at_end(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    return pos.i == vec->length; \
+} \
+\
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos) \
+{ \
+    return _##_C##_pos(pos.vec, pos.i + 1); \
+} \
+\
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos) \
+{ \
+    return _##_C##_pos(pos.vec, pos.i - 1); \
+} \
+\
+_funcspecs void _C##_forward(_C##_pos_t *pos) \
+{ \
+    pos->i++; \
+} \
+\
+_funcspecs void _C##_backward(_C##_pos_t *pos) \
+{ \
+    pos->i--; \
+} \
+\
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end) \
+{ \
+    assert(begin.vec == end.vec); \
+    return _##_C##_range(begin.vec, begin.i, end.i); \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range) \
+{ \
+    return _##_C##_pos(range.vec, range.begin); \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range) \
+{ \
+    return _##_C##_pos(range.vec, range.end); \
+} \
+\
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.begin; \
+} \
+\
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.i == range.end; \
+} \
+\
+_funcspecs _C##_range_t _C##_all(_C##_t *vec) \
+{ \
+    return _##_C##_range(vec, 0, vec->length); \
+} \
+\
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    assert(pos.vec == vec && pos.i <= vec->length); \
+    return _##_C##_range(vec, pos.i, vec->length); \
+} \
+\
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    assert(pos.vec == vec && pos.i <= vec->length); \
+    return _##_C##_range(vec, 0, pos.i); \
+} \
+\
+_funcspecs size_t _C##_range_length(_C##_range_t range) \
+{ \
+    assert(range.begin <= range.end); \
+    return range.end - range.begin; \
+} \
+\
+_funcspecs bool _C##_range_empty(_C##_range_t range) \
+{ \
+    return range.begin == range.end; \
+} \
+\
+_funcspecs struct _C##_rec _C##_front(_C##_t *vec) \
+{ \
+    assert(!_C##_empty(vec)); \
+    return _C##_at(vec, 0); \
+} \
+\
+_funcspecs struct _C##_rec _C##_back(_C##_t *vec) \
+{ \
+    assert(!_C##_empty(vec)); \
+    return _C##_at(vec, vec->length - 1); \
+} \
+\
+_funcspecs struct _C##_rec _C##_at(_C##_t *vec, size_t i) \
+{ \
+    assert(i < vec->length); \
+    return _C##_get(_##_C##_pos(vec, i)); \
+} \
+\
+_funcspecs struct _C##_rec _C##_get(_C##_pos_t pos) \
+{ \
+    struct _C *vec = pos.vec; \
+    size_t i = pos.i; \
+    struct _C##_rec rec; \
+\
+    _GCL_PP_MAP(_gcl_soa_get_col, (_C), __VA_ARGS__) \
+    return rec; \
+} \
+\
+_funcspecs void _C##_set(_C##_pos_t pos, struct _C##_rec rec) \
+{ \
+    struct _C *vec = pos.vec; \
+    size_t i = pos.i; \
+\
+    _GCL_PP_MAP(_gcl_soa_set_col, (_C), __VA_ARGS__) \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *vec, struct _C##_rec rec) \
+{ \
+    return _C##_insert(vec, _C##_begin(vec), rec); \
+} \
+\
+_funcspecs void _C##_remove_front(_C##_t *vec) \
+{ \
+    assert(!_C##_empty(vec)); \
+    _C##_remove(vec, _C##_begin(vec)); \
+} \
+\
+_funcspecs void _C##_remove_back(_C##_t *vec) \
+{ \
+    assert(!_C##_empty(vec)); \
+    _C##_remove(vec, _##_C##_pos(vec, vec->length - 1)); \
+} \
+\
+_GCL_PP_MAP(_gcl_soa_span_def, (_funcspecs, _C), __VA_ARGS__)
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Per-type container statistics.
+ *
+ * If GCL_STATS is defined, every vector, list and ring buffer type counts
+ * resizes, calls to _grow, bytes shifted by _move_data, storage allocations
+ * and frees, and the peak length, capacity and unused capacity of its
+ * instances.  The aligned, small and mmap vectors count the same except for
+ * allocations.  Without GCL_STATS, the counters and the hooks that update
+ * them compile to nothing.
+ *
+ * A type registers its counters on first use.  GCL_STATS_DEFINE must be
+ * expanded in exactly one source file; it defines the registry and
+ * gcl_stats_dump and gcl_stats_dump_json, which print the counters of all
+ * registered types as text or as JSON.  Types generated with the STATIC
+ * generators get separate counters in every translation unit.  The
+ * counters are not synchronized, so they are only exact if each type is
+ * used from a single thread.  Registration is not synchronized either and
+ * links the type into a global list, so no two types may be used for the
+ * first time concurrently; a multithreaded program should use every type
+ * once before starting its threads.
+ *
+ * Peak length and unused capacity are sampled by every call that changes
+ * the length or capacity of a container.  Peak lengths are not tracked for
+ * lists.
+ */
+
+#ifndef GCL_STATS_H
+#define GCL_STATS_H
+
+#ifdef GCL_STATS
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct gcl_stats {
+    const char *name;
+    size_t elem_size;
+    struct gcl_stats *next;
+    bool registered;
+    uint64_t resizes;
+    uint64_t grows;
+    uint64_t bytes_moved;
+    uint64_t allocs;
+    uint64_t frees;
+    size_t peak_length;
+    size_t peak_capacity;
+    size_t peak_unused;
+};
+
+#define GCL_STATS_INIT(_C, _T)          { .name = #_C, .elem_size = sizeof(_T) }
+
+extern struct gcl_stats *gcl_stats_registry;
+
+struct gcl_stats *gcl_stats_register(struct gcl_stats *stats);
+void gcl_stats_reset(void);
+void gcl_stats_dump(FILE *out);
+void gcl_stats_dump_json(FILE *out);
+
+#define GCL_STATS_DEFINE \
+\
+struct gcl_stats *gcl_stats_registry = NULL; \
+\
+struct gcl_stats *gcl_stats_register(struct gcl_stats *stats) \
+{ \
+    stats->next = gcl_stats_registry; \
+    stats->registered = true; \
+    gcl_stats_registry = stats; \
+    return stats; \
+} \
+\
+void gcl_stats_reset(void) \
+{ \
+    struct gcl_stats *stats; \
+\
+    for (stats = gcl_stats_registry; stats; stats = stats->next) { \
+        stats->resizes = 0; \
+        stats->grows = 0; \
+        stats->bytes_moved = 0; \
+        stats->allocs = 0; \
+        stats->frees = 0; \
+        stats->peak_length = 0; \
+        stats->peak_capacity = 0; \
+        stats->peak_unused = 0; \
+    } \
+} \
+\
+void gcl_stats_dump(FILE *out) \
+{ \
+    struct gcl_stats *stats; \
+\
+    fprintf(out, "%-24s %9s %12s %12s %16s %12s %12s %12s %12s %16s\n", \
+            "type", "elem_size", "resizes", "grows", "bytes_moved", "allocs", \
+            "frees", "peak_length", "peak_cap", "peak_unused_B"); \
+\
+    for (stats = gcl_stats_registry; stats; stats = stats->next) { \
+        fprintf(out, "%-24s %9zu %12llu %12llu %16llu %12llu %12llu %12zu %12zu %16llu\n", \
+                stats->name, stats->elem_size, \
+                (unsigned long long) stats->resizes, \
+                (unsigned long long) stats->grows, \
+                (unsigned long long) stats->bytes_moved, \
+                (unsigned long long) stats->allocs, \
+                (unsigned long long) stats->frees, \
+                stats->peak_length, stats->peak_capacity, \
+                (unsigned long long) stats->peak_unused * stats->elem_size); \
+    } \
+} \
+\
+void gcl_stats_dump_json(FILE *out) \
+{ \
+    struct gcl_stats *stats; \
+\
+    fputc('[', out); \
+\
+    for (stats = gcl_stats_registry; stats; stats = stats->next) { \
+        fprintf(out, "%s\n  {\"type\": \"%s\", \"elem_size\": %zu, \"resizes\": %llu, " \
+                "\"grows\": %llu, \"bytes_moved\": %llu, \"allocs\": %llu, " \
+                "\"frees\": %llu, \"peak_length\": %zu, \"peak_capacity\": %zu, " \
+                "\"peak_unused_bytes\": %llu}", \
+                stats == gcl_stats_registry ? "" : ",", \
+                stats->name, stats->elem_size, \
+                (unsigned long long) stats->resizes, \
+                (unsigned long long) stats->grows, \
+                (unsigned long long) stats->bytes_moved, \
+                (unsigned long long) stats->allocs, \
+                (unsigned long long) stats->frees, \
+                stats->peak_length, stats->peak_capacity, \
+                (unsigned long long) stats->peak_unused * stats->elem_size); \
+    } \
+\
+    fputs("\n]\n", out); \
+}
+
+#define _gcl_stats_define_static(_C, _T) \
+    static struct gcl_stats _##_C##_stats = GCL_STATS_INIT(_C, _T);
+
+#define _gcl_stats_declare_extern(_C) \
+    extern struct gcl_stats _##_C##_stats;
+
+#define _gcl_stats_define_extern(_C, _T) \
+    struct gcl_stats _##_C##_stats = GCL_STATS_INIT(_C, _T);
+
+#define _gcl_stats_get(_C) \
+    (_##_C##_stats.registered ? &_##_C##_stats : gcl_stats_register(&_##_C##_stats))
+
+#define _gcl_stats_max(field, val) \
+    ((field) < (val) ? (void) ((field) = (val)) : (void) 0)
+
+#define _gcl_stats_grow(_C) \
+    ((void) _gcl_stats_get(_C)->grows++)
+
+#define _gcl_stats_moved(_C, bytes) \
+    ((void) (_gcl_stats_get(_C)->bytes_moved += (bytes)))
+
+#define _gcl_stats_alloc(_C) \
+    ((void) _gcl_stats_get(_C)->allocs++)
+
+#define _gcl_stats_free(_C) \
+    ((void) _gcl_stats_get(_C)->frees++)
+
+#define _gcl_stats_length(_C, length) \
+    _gcl_stats_max(_gcl_stats_get(_C)->peak_length, (size_t) (length))
+
+#define _gcl_stats_capacity(_C, capacity, length) \
+    do { \
+        struct gcl_stats *_stats = _gcl_stats_get(_C); \
+        _gcl_stats_max(_stats->peak_capacity, (size_t) (capacity)); \
+        _gcl_stats_max(_stats->peak_unused, (size_t) (capacity) - (size_t) (length)); \
+    } while (0)
+
+#define _gcl_stats_resize(_C, capacity, length) \
+    do { \
+        _gcl_stats_get(_C)->resizes++; \
+        _gcl_stats_capacity(_C, capacity, length); \
+    } while (0)
+
+#else
+
+#define GCL_STATS_DEFINE
+
+#define _gcl_stats_define_static(_C, _T)
+#define _gcl_stats_declare_extern(_C)
+#define _gcl_stats_define_extern(_C, _T)
+
+#define _gcl_stats_grow(_C)                         ((void) 0)
+#define _gcl_stats_moved(_C, bytes)                 ((void) 0)
+#define _gcl_stats_alloc(_C)                        ((void) 0)
+#define _gcl_stats_free(_C)                         ((void) 0)
+#define _gcl_stats_length(_C, length)               ((void) 0)
+#define _gcl_stats_capacity(_C, capacity, length)   ((void) 0)
+#define _gcl_stats_resize(_C, capacity, length)     ((void) 0)
+
+#endif
+
+#endif
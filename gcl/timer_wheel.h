@@ -0,0 +1,313 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * A hierarchical timing wheel for large numbers of timeouts.  Objects
+ * embed a struct gcl_timer member and are linked into intrusive lists, one
+ * per bucket, so scheduling and cancelling never allocate and cost O(1).
+ *
+ * Time is an arbitrary 64-bit unit (nanoseconds, milliseconds, ...) that
+ * the wheel divides into ticks of the size given to init_##_C.  Level l of
+ * the wheel is a ring of GCL_TIMER_WHEEL_SLOTS buckets of
+ * GCL_TIMER_WHEEL_SLOTS^l ticks each, indexed by masking the expiry tick.
+ * When level 0 wraps around, the due bucket of the next level is cascaded,
+ * that is, its timers are redistributed to the lower levels.  Timers further
+ * in the future than the wheel covers wait in the top level and are
+ * cascaded until they are in range.  Timers expire at the first tick at or
+ * after their expiry time, never earlier.
+ *
+ * _C##_advance moves all timers that have expired up to a given time to
+ * the back of a caller-supplied list, bucket by bucket in O(1) per bucket,
+ * and skips ahead to the next occupied level 0 bucket or cascade.  The
+ * caller then takes the timers off that list with _C##_slot_remove_front or
+ * iterates over it.  A timer is pending from _C##_schedule until it is taken
+ * off that list or cancelled; _C##_cancel also removes a timer from the list
+ * of expired timers.
+ *
+ *     struct conn {
+ *         struct gcl_timer idle_timer;
+ *     };
+ *
+ *     GCL_GENERATE_TIMER_WHEEL_TYPES(conn_timers, struct conn, idle_timer)
+ *     GCL_GENERATE_TIMER_WHEEL_FUNCTIONS_STATIC(conn_timers, struct conn, idle_timer)
+ */
+
+#ifndef GCL_TIMER_WHEEL_H
+#define GCL_TIMER_WHEEL_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bits.h"
+#include "intrusive_list.h"
+
+#ifndef GCL_TIMER_WHEEL_BITS
+#define GCL_TIMER_WHEEL_BITS            (6)
+#endif
+
+#ifndef GCL_TIMER_WHEEL_LEVELS
+#define GCL_TIMER_WHEEL_LEVELS          (6)
+#endif
+
+#if GCL_TIMER_WHEEL_BITS > 6 || GCL_TIMER_WHEEL_BITS * GCL_TIMER_WHEEL_LEVELS >= 64
+#error "The timing wheel must have at most 64 slots per level and cover less than 2^64 ticks"
+#endif
+
+#define GCL_TIMER_WHEEL_SLOTS           (1u << GCL_TIMER_WHEEL_BITS)
+
+#define _gcl_timer_wheel_mask           ((uint64_t) GCL_TIMER_WHEEL_SLOTS - 1)
+#define _gcl_timer_wheel_range          ((uint64_t) 1 << (GCL_TIMER_WHEEL_BITS * GCL_TIMER_WHEEL_LEVELS))
+#define _gcl_timer_wheel_bit(i)         ((uint64_t) 1 << (i))
+
+struct gcl_timer {
+    struct gcl_list_link link;
+    uint64_t expires;
+    unsigned slot;
+};
+
+#define GCL_GENERATE_TIMER_WHEEL_TYPES(_C, _T, _timer) \
+    GCL_GENERATE_INTRUSIVE_LIST_TYPES(_C##_slot, _T, _timer.link) \
+\
+typedef struct _C _C##_t; \
+typedef _T *_C##_elem_t; \
+\
+struct _C { \
+    uint64_t origin; \
+    uint64_t tick; \
+    uint64_t current; \
+    uint64_t occupied[GCL_TIMER_WHEEL_LEVELS]; \
+    _C##_slot_t slots[GCL_TIMER_WHEEL_LEVELS * GCL_TIMER_WHEEL_SLOTS]; \
+};
+
+#define GCL_GENERATE_TIMER_WHEEL_FUNCTIONS_STATIC(_C, _T, _timer) \
+    GCL_GENERATE_INTRUSIVE_LIST_FUNCTIONS_STATIC(_C##_slot, _T, _timer.link) \
+    GCL_GENERATE_TIMER_WHEEL_LONG_FUNCTION_DECLS(_C, _T, _timer, static) \
+    GCL_GENERATE_TIMER_WHEEL_SHORT_FUNCTION_DECLS(_C, _T, _timer, static inline) \
+    GCL_GENERATE_TIMER_WHEEL_LONG_FUNCTION_DEFS(_C, _T, _timer, static) \
+    GCL_GENERATE_TIMER_WHEEL_SHORT_FUNCTION_DEFS(_C, _T, _timer, static inline)
+
+#define GCL_GENERATE_TIMER_WHEEL_FUNCTIONS_EXTERN_H(_C, _T, _timer) \
+    GCL_GENERATE_INTRUSIVE_LIST_FUNCTIONS_EXTERN_H(_C##_slot, _T, _timer.link) \
+    GCL_GENERATE_TIMER_WHEEL_LONG_FUNCTION_DECLS(_C, _T, _timer, ) \
+    GCL_GENERATE_TIMER_WHEEL_SHORT_FUNCTION_DECLS(_C, _T, _timer, inline) \
+    GCL_GENERATE_TIMER_WHEEL_SHORT_FUNCTION_DEFS(_C, _T, _timer, inline)
+
+#define GCL_GENERATE_TIMER_WHEEL_FUNCTIONS_EXTERN_C(_C, _T, _timer) \
+    GCL_GENERATE_INTRUSIVE_LIST_FUNCTIONS_EXTERN_C(_C##_slot, _T, _timer.link) \
+    GCL_GENERATE_TIMER_WHEEL_LONG_FUNCTION_DEFS(_C, _T, _timer, ) \
+    GCL_GENERATE_TIMER_WHEEL_SHORT_FUNCTION_DECLS(_C, _T, _timer, )
+
+#define GCL_GENERATE_TIMER_WHEEL_LONG_FUNCTION_DECLS(_C, _T, _timer, _funcspecs) \
+\
+_funcspecs void _##_C##_add(struct _C *wheel, _T *obj); \
+_funcspecs void _##_C##_cascade(struct _C *wheel, uint64_t t); \
+_funcspecs void _C##_advance(_C##_t *wheel, uint64_t time, _C##_slot_t *expired); \
+_funcspecs void _C##_clear(_C##_t *wheel);
+
+#define GCL_GENERATE_TIMER_WHEEL_SHORT_FUNCTION_DECLS(_C, _T, _timer, _funcspecs) \
+\
+_funcspecs uint64_t _##_C##_tick_of_time(struct _C *wheel, uint64_t time); \
+_funcspecs uint64_t _##_C##_next_tick(struct _C *wheel, uint64_t t); \
+_funcspecs void init_##_C(struct _C *wheel, uint64_t origin, uint64_t tick); \
+_funcspecs bool _C##_empty(_C##_t *wheel); \
+_funcspecs uint64_t _C##_time(_C##_t *wheel); \
+_funcspecs bool _C##_pending(_T *obj); \
+_funcspecs void _C##_schedule(_C##_t *wheel, _T *obj, uint64_t time); \
+_funcspecs bool _C##_cancel(_C##_t *wheel, _T *obj); \
+_funcspecs void _C##_reschedule(_C##_t *wheel, _T *obj, uint64_t time);
+
+#define GCL_GENERATE_TIMER_WHEEL_LONG_FUNCTION_DEFS(_C, _T, _timer, _funcspecs) \
+\
+_funcspecs void _##_C##_add(struct _C *wheel, _T *obj) \
+{ \
+    uint64_t expires = obj->_timer.expires; \
+    uint64_t delta; \
+    unsigned level = 0, i; \
+\
+    if (expires < wheel->current) \
+        expires = wheel->current; \
+\
+    delta = expires - wheel->current; \
+\
+    if (delta >= _gcl_timer_wheel_range) { \
+        delta = _gcl_timer_wheel_range - 1; \
+        expires = wheel->current + delta; \
+    } \
+\
+    while (level < GCL_TIMER_WHEEL_LEVELS - 1 && \
+           delta >> (GCL_TIMER_WHEEL_BITS * (level + 1))) \
+        level++; \
+\
+    i = (unsigned) ((expires >> (GCL_TIMER_WHEEL_BITS * level)) & _gcl_timer_wheel_mask); \
+    obj->_timer.slot = level * GCL_TIMER_WHEEL_SLOTS + i; \
+    wheel->occupied[level] |= _gcl_timer_wheel_bit(i); \
+    _C##_slot_insert_back(&wheel->slots[obj->_timer.slot], obj); \
+} \
+\
+_funcspecs void _##_C##_cascade(struct _C *wheel, uint64_t t) \
+{ \
+    _C##_slot_t tmp, *slot; \
+    unsigned level, i; \
+\
+    init_##_C##_slot(&tmp); \
+\
+    for (level = 1; level < GCL_TIMER_WHEEL_LEVELS; level++) { \
+        i = (unsigned) ((t >> (GCL_TIMER_WHEEL_BITS * level)) & _gcl_timer_wheel_mask); \
+\
+        if (wheel->occupied[level] & _gcl_timer_wheel_bit(i)) { \
+            slot = &wheel->slots[level * GCL_TIMER_WHEEL_SLOTS + i]; \
+            _C##_slot_splice_back(&tmp, slot, _C##_slot_all(slot)); \
+            wheel->occupied[level] &= ~_gcl_timer_wheel_bit(i); \
+\
+            while (!_C##_slot_empty(&tmp)) \
+                _##_C##_add(wheel, _C##_slot_remove_front(&tmp)); \
+        } \
+\
+        if (i != 0) \
+            break; \
+    } \
+} \
+\
+_funcspecs void _C##_advance(_C##_t *wheel, uint64_t time, _C##_slot_t *expired) \
+{ \
+    uint64_t target, t, next; \
+    unsigned i; \
+\
+    if (time < wheel->origin) \
+        return; \
+\
+    target = (time - wheel->origin) / wheel->tick; \
+\
+    while (wheel->current <= target) { \
+        if (_C##_empty(wheel)) { \
+            wheel->current = target + 1; \
+            break; \
+        } \
+\
+        t = wheel->current; \
+        i = (unsigned) (t & _gcl_timer_wheel_mask); \
+\
+        if (i == 0) \
+            _##_C##_cascade(wheel, t); \
+\
+        if (wheel->occupied[0] & _gcl_timer_wheel_bit(i)) { \
+            _C##_slot_splice_back(expired, &wheel->slots[i], _C##_slot_all(&wheel->slots[i])); \
+            wheel->occupied[0] &= ~_gcl_timer_wheel_bit(i); \
+        } \
+\
+        next = _##_C##_next_tick(wheel, t); \
+        wheel->current = next <= target ? next : target + 1; \
+    } \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *wheel) \
+{ \
+    unsigned i; \
+\
+    for (i = 0; i < GCL_TIMER_WHEEL_LEVELS * GCL_TIMER_WHEEL_SLOTS; i++) \
+        _C##_slot_clear(&wheel->slots[i]); \
+\
+    for (i = 0; i < GCL_TIMER_WHEEL_LEVELS; i++) \
+        wheel->occupied[i] = 0; \
+}
+
+#define GCL_GENERATE_TIMER_WHEEL_SHORT_FUNCTION_DEFS(_C, _T, _timer, _funcspecs) \
+\
+_funcspecs uint64_t _##_C##_tick_of_time(struct _C *wheel, uint64_t time) \
+{ \
+    uint64_t d; \
+\
+    if (time <= wheel->origin) \
+        return 0; \
+\
+    d = time - wheel->origin; \
+    return d / wheel->tick + (d % wheel->tick != 0); \
+} \
+\
+_funcspecs uint64_t _##_C##_next_tick(struct _C *wheel, uint64_t t) \
+{ \
+    unsigned i = (unsigned) (t & _gcl_timer_wheel_mask); \
+    uint64_t rest; \
+\
+    if (i == _gcl_timer_wheel_mask) \
+        return t + 1; \
+\
+    rest = wheel->occupied[0] >> (i + 1); \
+    return rest ? t + 1 + _gcl_ctz64(rest) : (t | _gcl_timer_wheel_mask) + 1; \
+} \
+\
+_funcspecs void init_##_C(struct _C *wheel, uint64_t origin, uint64_t tick) \
+{ \
+    unsigned i; \
+\
+    assert(tick > 0); \
+\
+    wheel->origin = origin; \
+    wheel->tick = tick; \
+    wheel->current = 0; \
+\
+    for (i = 0; i < GCL_TIMER_WHEEL_LEVELS * GCL_TIMER_WHEEL_SLOTS; i++) \
+        init_##_C##_slot(&wheel->slots[i]); \
+\
+    for (i = 0; i < GCL_TIMER_WHEEL_LEVELS; i++) \
+        wheel->occupied[i] = 0; \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *wheel) \
+{ \
+    uint64_t occupied = 0; \
+    unsigned i; \
+\
+    for (i = 0; i < GCL_TIMER_WHEEL_LEVELS; i++) \
+        occupied |= wheel->occupied[i]; \
+\
+    return occupied == 0; \
+} \
+\
+_funcspecs uint64_t _C##_time(_C##_t *wheel) \
+{ \
+    return wheel->origin + wheel->current * wheel->tick; \
+} \
+\
+_funcspecs bool _C##_pending(_T *obj) \
+{ \
+    return _C##_slot_linked(obj); \
+} \
+\
+_funcspecs void _C##_schedule(_C##_t *wheel, _T *obj, uint64_t time) \
+{ \
+    assert(!_C##_pending(obj)); \
+\
+    obj->_timer.expires = _##_C##_tick_of_time(wheel, time); \
+    _##_C##_add(wheel, obj); \
+} \
+\
+_funcspecs bool _C##_cancel(_C##_t *wheel, _T *obj) \
+{ \
+    _C##_slot_t *slot; \
+\
+    if (!_C##_pending(obj)) \
+        return false; \
+\
+    slot = &wheel->slots[obj->_timer.slot]; \
+    _C##_slot_remove_elem(slot, obj); \
+\
+    if (_C##_slot_empty(slot)) \
+        wheel->occupied[obj->_timer.slot / GCL_TIMER_WHEEL_SLOTS] &= \
+            ~_gcl_timer_wheel_bit(obj->_timer.slot % GCL_TIMER_WHEEL_SLOTS); \
+\
+    return true; \
+} \
+\
+_funcspecs void _C##_reschedule(_C##_t *wheel, _T *obj, uint64_t time) \
+{ \
+    _C##_cancel(wheel, obj); \
+    _C##_schedule(wheel, obj, time); \
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * Compile-time element traits.
+ *
+ * A traits set is a name prefix for six macros:
+ *
+ *   name_trivial       1 if destroying an element does nothing, else 0
+ *   name_destroy(x)    releases the resources of element x
+ *   name_copy(x)       returns a copy of element x
+ *   name_eq(x, y)      true if x and y are equal
+ *   name_cmp(x, y)     negative, zero or positive as x < y, x == y, x > y
+ *   name_hash(x)       a size_t hash of x, consistent with name_eq
+ *
+ * The containers generated with the GCL_GENERATE_*_EX generators take the
+ * name of a traits set as an additional argument and destroy elements with
+ * name_destroy instead of calling through their destroy_elem member, which
+ * they ignore.  For trivial elements, destroy and clear do not touch the
+ * elements at all.  The algorithms in alg.h whose names end in _traits
+ * compare and copy elements with the traits macros.
+ *
+ * The containers access their elements' destructor through two generated
+ * functions, _##_C##_trivial_elem and _##_C##_destroy_elem.  The
+ * GCL_GENERATE_ELEM_FUNCTION_DEFS generator defines them in terms of the
+ * destroy_elem member, GCL_GENERATE_ELEM_FUNCTION_DEFS_EX in terms of a
+ * traits set.
+ */
+
+#ifndef GCL_TRAITS_H
+#define GCL_TRAITS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define _gcl_traits_trivial(traits)     (traits##_trivial)
+#define _gcl_traits_destroy(traits, x)  traits##_destroy(x)
+#define _gcl_traits_copy(traits, x)     traits##_copy(x)
+#define _gcl_traits_eq(traits, x, y)    traits##_eq(x, y)
+#define _gcl_traits_cmp(traits, x, y)   traits##_cmp(x, y)
+#define _gcl_traits_hash(traits, x)     traits##_hash(x)
+
+/* Integers, floating-point numbers and pointers that are not owned. */
+#define gcl_scalar_traits_trivial       1
+#define gcl_scalar_traits_destroy(x)    ((void) (x))
+#define gcl_scalar_traits_copy(x)       (x)
+#define gcl_scalar_traits_eq(x, y)      ((x) == (y))
+#define gcl_scalar_traits_cmp(x, y)     (((x) > (y)) - ((x) < (y)))
+#define gcl_scalar_traits_hash(x)       ((size_t) (x))
+
+/* Null-terminated strings allocated with malloc and owned by the container. */
+#define gcl_str_traits_trivial          0
+#define gcl_str_traits_destroy(x)       free(x)
+#define gcl_str_traits_copy(x)          _gcl_strdup(x)
+#define gcl_str_traits_eq(x, y)         (strcmp(x, y) == 0)
+#define gcl_str_traits_cmp(x, y)        strcmp(x, y)
+#define gcl_str_traits_hash(x)          _gcl_str_hash(x)
+
+static inline char *_gcl_strdup(const char *s)
+{
+    size_t size = strlen(s) + 1;
+    char *copy;
+
+    if ((copy = malloc(size)))
+        memcpy(copy, s, size);
+    return copy;
+}
+
+/* FNV-1a */
+static inline size_t _gcl_str_hash(const char *s)
+{
+    size_t hash = (size_t) 2166136261u;
+
+    while (*s) {
+        hash ^= (unsigned char) *s++;
+        hash *= (size_t) 16777619u;
+    }
+
+    return hash;
+}
+
+#define GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs bool _##_C##_trivial_elem(struct _C *cont); \
+_funcspecs void _##_C##_destroy_elem(struct _C *cont, _T val);
+
+#define GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs bool _##_C##_trivial_elem(struct _C *cont) \
+{ \
+    return !cont->destroy_elem; \
+} \
+\
+_funcspecs void _##_C##_destroy_elem(struct _C *cont, _T val) \
+{ \
+    if (cont->destroy_elem) \
+        cont->destroy_elem(val); \
+}
+
+#define GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, _funcspecs) \
+\
+_funcspecs bool _##_C##_trivial_elem(struct _C *cont) \
+{ \
+    (void) cont; \
+    return _gcl_traits_trivial(traits); \
+} \
+\
+_funcspecs void _##_C##_destroy_elem(struct _C *cont, _T val) \
+{ \
+    (void) cont; \
+    _gcl_traits_destroy(traits, val); \
+}
+
+#endif
@@ -0,0 +1,529 @@
+/*
+ * Copyright 2012 Holger Arnold.
+ *
+ * Licensed under a modified BSD license.
+ * See the accompanying LICENSE file for details.
+ */
+
+/*
+ * An unrolled list stores up to K elements per node.  Full nodes are split
+ * on insertion, and a node that becomes less than a quarter full on removal
+ * is merged with its successor if both fit into one node.  A list never
+ * contains empty nodes.
+ *
+ * Positions are (node, index) pairs and are invalidated by insertions and
+ * removals in the same node.  Splicing splits the affected nodes at the
+ * range and insertion boundaries and then relinks whole nodes.
+ */
+
+#ifndef GCL_UNROLLED_LIST_H
+#define GCL_UNROLLED_LIST_H
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef GCL_ERROR
+#define GCL_ERROR(errnum, ...)
+#endif
+
+#define _gcl_unrolled_list_node_capacity(node) \
+    (sizeof((node)->elems) / sizeof(*(node)->elems))
+
+#define GCL_GENERATE_UNROLLED_LIST_TYPES(_C, _T, K) \
+\
+typedef struct _C _C##_t; \
+typedef struct _C##_pos _C##_pos_t; \
+typedef struct _C##_range _C##_range_t; \
+typedef _T _C##_elem_t; \
+\
+struct _C##_link { \
+    struct _C##_link *next; \
+    struct _C##_link *prev; \
+}; \
+\
+struct _C##_node { \
+    struct _C##_link link; \
+    size_t count; \
+    _T elems[K]; \
+}; \
+\
+struct _C##_pos { \
+    struct _C##_link *node; \
+    size_t i; \
+}; \
+\
+struct _C##_range { \
+    struct _C##_pos begin; \
+    struct _C##_pos end; \
+}; \
+\
+struct _C { \
+    struct _C##_link end; \
+    void (*destroy_elem)(_T); \
+};
+
+#define GCL_GENERATE_UNROLLED_LIST_FUNCTIONS_STATIC(_C, _T) \
+    GCL_GENERATE_UNROLLED_LIST_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_UNROLLED_LIST_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_UNROLLED_LIST_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_UNROLLED_LIST_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_UNROLLED_LIST_FUNCTIONS_EXTERN_H(_C, _T) \
+    GCL_GENERATE_UNROLLED_LIST_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_UNROLLED_LIST_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_UNROLLED_LIST_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_UNROLLED_LIST_FUNCTIONS_EXTERN_C(_C, _T) \
+    GCL_GENERATE_UNROLLED_LIST_LONG_FUNCTION_DEFS(_C, _T, ) \
+    GCL_GENERATE_UNROLLED_LIST_SHORT_FUNCTION_DECLS(_C, _T, )
+
+#define GCL_GENERATE_UNROLLED_LIST_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs struct _C##_node *_##_C##_new_node(struct _C##_link *prev); \
+_funcspecs void _##_C##_free_node(struct _C##_node *node); \
+_funcspecs bool _##_C##_split(struct _C *list, struct _C##_pos *pos); \
+_funcspecs void destroy_##_C(struct _C *list); \
+_funcspecs _C##_pos_t _C##_insert(_C##_t *list, _C##_pos_t pos, _T val); \
+_funcspecs _C##_pos_t _C##_release(_C##_t *list, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_remove(_C##_t *list, _C##_pos_t pos); \
+_funcspecs void _C##_clear(_C##_t *list); \
+_funcspecs bool _C##_splice(_C##_t *dest_list, _C##_pos_t pos, _C##_t *src_list, _C##_range_t range); \
+_funcspecs void _C##_swap(_C##_t *list1, _C##_t *list2);
+
+#define GCL_GENERATE_UNROLLED_LIST_SHORT_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs void init_##_C(struct _C *list, void (*destroy_elem)(_T)); \
+_funcspecs struct _C##_node *_##_C##_node(struct _C##_link *link); \
+_funcspecs void _##_C##_link_nodes(struct _C##_link *prev, struct _C##_link *next); \
+_funcspecs _C##_pos_t _##_C##_pos(struct _C##_link *node, size_t i); \
+_funcspecs size_t _C##_length(_C##_t *list); \
+_funcspecs bool _C##_empty(_C##_t *list); \
+_funcspecs _C##_pos_t _C##_begin(_C##_t *list); \
+_funcspecs _C##_pos_t _C##_end(_C##_t *list); \
+_funcspecs bool _C##_at_begin(_C##_t *list, _C##_pos_t pos); \
+_funcspecs bool _C##_at_end(_C##_t *list, _C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos); \
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos); \
+_funcspecs void _C##_forward(_C##_pos_t *pos); \
+_funcspecs void _C##_backward(_C##_pos_t *pos); \
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end); \
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range); \
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range); \
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_all(_C##_t *list); \
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *list, _C##_pos_t pos); \
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *list, _C##_pos_t pos); \
+_funcspecs bool _C##_range_empty(_C##_range_t range); \
+_funcspecs _T _C##_front(_C##_t *list); \
+_funcspecs _T _C##_back(_C##_t *list); \
+_funcspecs _T _C##_get(_C##_pos_t pos); \
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos); \
+_funcspecs void _C##_set(_C##_pos_t pos, _T val); \
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T val); \
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T val); \
+_funcspecs void _C##_remove_front(_C##_t *list); \
+_funcspecs void _C##_remove_back(_C##_t *list); \
+_funcspecs bool _C##_splice_front(_C##_t *dest_list, _C##_t *src_list, _C##_range_t range); \
+_funcspecs bool _C##_splice_back(_C##_t *dest_list, _C##_t *src_list, _C##_range_t range);
+
+#define GCL_GENERATE_UNROLLED_LIST_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs struct _C##_node *_##_C##_new_node(struct _C##_link *prev) \
+{ \
+    struct _C##_node *node; \
+\
+    if (!(node = malloc(sizeof(*node)))) { \
+        GCL_ERROR(errno, "Allocating memory for list node failed"); \
+        return NULL; \
+    } \
+\
+    node->count = 0; \
+    _##_C##_link_nodes(&node->link, prev->next); \
+    _##_C##_link_nodes(prev, &node->link); \
+    return node; \
+} \
+\
+_funcspecs void _##_C##_free_node(struct _C##_node *node) \
+{ \
+    _##_C##_link_nodes(node->link.prev, node->link.next); \
+    free(node); \
+} \
+\
+_funcspecs bool _##_C##_split(struct _C *list, struct _C##_pos *pos) \
+{ \
+    struct _C##_node *node, *new_node; \
+\
+    if (pos->i == 0) \
+        return true; \
+\
+    assert(pos->node != &list->end); \
+\
+    node = _##_C##_node(pos->node); \
+\
+    if (!(new_node = _##_C##_new_node(&node->link))) \
+        return false; \
+\
+    new_node->count = node->count - pos->i; \
+    memcpy(new_node->elems, node->elems + pos->i, new_node->count * sizeof(_T)); \
+    node->count = pos->i; \
+    *pos = _##_C##_pos(&new_node->link, 0); \
+    return true; \
+} \
+\
+_funcspecs void destroy_##_C(struct _C *list) \
+{ \
+    struct _C##_link *link, *tmp; \
+    size_t i; \
+\
+    for (link = list->end.next; link != &list->end; link = tmp) { \
+        struct _C##_node *node = _##_C##_node(link); \
+        tmp = link->next; \
+        if (list->destroy_elem) { \
+            for (i = 0; i < node->count; i++) \
+                list->destroy_elem(node->elems[i]); \
+        } \
+        free(node); \
+    } \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert(_C##_t *list, _C##_pos_t pos, _T val) \
+{ \
+    struct _C##_node *node, *new_node; \
+    size_t k, half; \
+\
+    if (pos.i == 0 && pos.node->prev != &list->end) { \
+        node = _##_C##_node(pos.node->prev); \
+        if (node->count < _gcl_unrolled_list_node_capacity(node)) { \
+            node->elems[node->count] = val; \
+            return _##_C##_pos(&node->link, node->count++); \
+        } \
+    } \
+\
+    if (pos.node == &list->end) { \
+        if (!(node = _##_C##_new_node(list->end.prev))) \
+            return _##_C##_pos(NULL, 0); \
+        node->elems[0] = val; \
+        node->count = 1; \
+        return _##_C##_pos(&node->link, 0); \
+    } \
+\
+    node = _##_C##_node(pos.node); \
+    k = _gcl_unrolled_list_node_capacity(node); \
+\
+    if (node->count == k) { \
+        if (!(new_node = _##_C##_new_node(&node->link))) \
+            return _##_C##_pos(NULL, 0); \
+        half = k / 2; \
+        new_node->count = k - half; \
+        memcpy(new_node->elems, node->elems + half, new_node->count * sizeof(_T)); \
+        node->count = half; \
+        if (pos.i > half) { \
+            node = new_node; \
+            pos = _##_C##_pos(&new_node->link, pos.i - half); \
+        } \
+    } \
+\
+    memmove(node->elems + pos.i + 1, node->elems + pos.i, \
+            (node->count - pos.i) * sizeof(_T)); \
+    node->elems[pos.i] = val; \
+    node->count++; \
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_release(_C##_t *list, _C##_pos_t pos) \
+{ \
+    assert(pos.node != &list->end); \
+\
+    struct _C##_node *node = _##_C##_node(pos.node); \
+    struct _C##_node *next; \
+    size_t k = _gcl_unrolled_list_node_capacity(node); \
+\
+    memmove(node->elems + pos.i, node->elems + pos.i + 1, \
+            (node->count - pos.i - 1) * sizeof(_T)); \
+\
+    if (--node->count == 0) { \
+        pos = _##_C##_pos(node->link.next, 0); \
+        _##_C##_free_node(node); \
+        return pos; \
+    } \
+\
+    if (node->count < k / 4 && node->link.next != &list->end) { \
+        next = _##_C##_node(node->link.next); \
+        if (node->count + next->count <= k) { \
+            memcpy(node->elems + node->count, next->elems, next->count * sizeof(_T)); \
+            node->count += next->count; \
+            _##_C##_free_node(next); \
+        } \
+    } \
+\
+    if (pos.i == node->count) \
+        return _##_C##_pos(node->link.next, 0); \
+\
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_remove(_C##_t *list, _C##_pos_t pos) \
+{ \
+    assert(pos.node != &list->end); \
+\
+    if (list->destroy_elem) \
+        list->destroy_elem(_C##_get(pos)); \
+\
+    return _C##_release(list, pos); \
+} \
+\
+_funcspecs void _C##_clear(_C##_t *list) \
+{ \
+    destroy_##_C(list); \
+    init_##_C(list, list->destroy_elem); \
+} \
+\
+_funcspecs bool _C##_splice(_C##_t *dest_list, _C##_pos_t pos, _C##_t *src_list, _C##_range_t range) \
+{ \
+    struct _C##_link *first, *last; \
+\
+    if (_C##_range_empty(range)) \
+        return true; \
+\
+    if (range.begin.node == range.end.node && range.begin.i > 0) { \
+        range.end.i -= range.begin.i; \
+        if (!_##_C##_split(src_list, &range.begin)) \
+            return false; \
+        range.end.node = range.begin.node; \
+    } else if (!_##_C##_split(src_list, &range.begin)) { \
+        return false; \
+    } \
+\
+    if (!_##_C##_split(src_list, &range.end) || !_##_C##_split(dest_list, &pos)) \
+        return false; \
+\
+    first = range.begin.node; \
+    last = range.end.node->prev; \
+    _##_C##_link_nodes(first->prev, range.end.node); \
+    _##_C##_link_nodes(pos.node->prev, first); \
+    _##_C##_link_nodes(last, pos.node); \
+    return true; \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *list1, _C##_t *list2) \
+{ \
+    struct _C tmp = *list1; \
+    *list1 = *list2; \
+    *list2 = tmp; \
+\
+    if (list1->end.next == &list2->end) { \
+        _##_C##_link_nodes(&list1->end, &list1->end); \
+    } else { \
+        _##_C##_link_nodes(&list1->end, list1->end.next); \
+        _##_C##_link_nodes(list1->end.prev, &list1->end); \
+    } \
+\
+    if (list2->end.next == &list1->end) { \
+        _##_C##_link_nodes(&list2->end, &list2->end); \
+    } else { \
+        _##_C##_link_nodes(&list2->end, list2->end.next); \
+        _##_C##_link_nodes(list2->end.prev, &list2->end); \
+    } \
+}
+
+#define GCL_GENERATE_UNROLLED_LIST_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs void init_##_C(struct _C *list, void (*destroy_elem)(_T)) \
+{ \
+    *list = (struct _C) { \
+        .end = { .next = &list->end, .prev = &list->end }, \
+        .destroy_elem = destroy_elem \
+    }; \
+} \
+\
+_funcspecs struct _C##_node *_##_C##_node(struct _C##_link *link) \
+{ \
+    return (struct _C##_node *) link; \
+} \
+\
+_funcspecs void _##_C##_link_nodes(struct _C##_link *prev, struct _C##_link *next) \
+{ \
+    prev->next = next; \
+    next->prev = prev; \
+} \
+\
+_funcspecs _C##_pos_t _##_C##_pos(struct _C##_link *node, size_t i) \
+{ \
+    return (struct _C##_pos) { .node = node, .i = i }; \
+} \
+\
+_funcspecs size_t _C##_length(_C##_t *list) \
+{ \
+    struct _C##_link *link; \
+    size_t n = 0; \
+\
+    for (link = list->end.next; link != &list->end; link = link->next) \
+        n += _##_C##_node(link)->count; \
+\
+    return n; \
+} \
+\
+_funcspecs bool _C##_empty(_C##_t *list) \
+{ \
+    return list->end.next == &list->end; \
+} \
+\
+_funcspecs _C##_pos_t _C##_begin(_C##_t *list) \
+{ \
+    return _##_C##_pos(list->end.next, 0); \
+} \
+\
+_funcspecs _C##_pos_t _C##_end(_C##_t *list) \
+{ \
+    return _##_C##_pos(&list->end, 0); \
+} \
+\
+_funcspecs bool _C##_at_begin(_C##_t *list, _C##_pos_t pos) \
+{ \
+    return pos.node == list->end.next && pos.i == 0; \
+} \
+\
+_funcspecs bool _C##_at_end(_C##_t *list, _C##_pos_t pos) \
+{ \
+    return pos.node == &list->end; \
+} \
+\
+_funcspecs _C##_pos_t _C##_next(_C##_pos_t pos) \
+{ \
+    _C##_forward(&pos); \
+    return pos; \
+} \
+\
+_funcspecs _C##_pos_t _C##_prev(_C##_pos_t pos) \
+{ \
+    _C##_backward(&pos); \
+    return pos; \
+} \
+\
+_funcspecs void _C##_forward(_C##_pos_t *pos) \
+{ \
+    if (++pos->i == _##_C##_node(pos->node)->count) { \
+        pos->node = pos->node->next; \
+        pos->i = 0; \
+    } \
+} \
+\
+_funcspecs void _C##_backward(_C##_pos_t *pos) \
+{ \
+    if (pos->i == 0) { \
+        pos->node = pos->node->prev; \
+        pos->i = _##_C##_node(pos->node)->count; \
+    } \
+    pos->i--; \
+} \
+\
+_funcspecs _C##_range_t _C##_range(_C##_pos_t begin, _C##_pos_t end) \
+{ \
+    return (struct _C##_range) { begin, end }; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_begin(_C##_range_t range) \
+{ \
+    return range.begin; \
+} \
+\
+_funcspecs _C##_pos_t _C##_range_end(_C##_range_t range) \
+{ \
+    return range.end; \
+} \
+\
+_funcspecs bool _C##_range_at_begin(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.node == range.begin.node && pos.i == range.begin.i; \
+} \
+\
+_funcspecs bool _C##_range_at_end(_C##_range_t range, _C##_pos_t pos) \
+{ \
+    return pos.node == range.end.node && pos.i == range.end.i; \
+} \
+\
+_funcspecs _C##_range_t _C##_all(_C##_t *list) \
+{ \
+    return (struct _C##_range) { _C##_begin(list), _C##_end(list) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_from_pos(_C##_t *list, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { pos, _C##_end(list) }; \
+} \
+\
+_funcspecs _C##_range_t _C##_range_to_pos(_C##_t *list, _C##_pos_t pos) \
+{ \
+    return (struct _C##_range) { _C##_begin(list), pos }; \
+} \
+\
+_funcspecs bool _C##_range_empty(_C##_range_t range) \
+{ \
+    return _C##_range_at_end(range, range.begin); \
+} \
+\
+_funcspecs _T _C##_front(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    return _##_C##_node(list->end.next)->elems[0]; \
+} \
+\
+_funcspecs _T _C##_back(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    struct _C##_node *node = _##_C##_node(list->end.prev); \
+    return node->elems[node->count - 1]; \
+} \
+\
+_funcspecs _T _C##_get(_C##_pos_t pos) \
+{ \
+    return _##_C##_node(pos.node)->elems[pos.i]; \
+} \
+\
+_funcspecs _T *_C##_get_ptr(_C##_pos_t pos) \
+{ \
+    return &_##_C##_node(pos.node)->elems[pos.i]; \
+} \
+\
+_funcspecs void _C##_set(_C##_pos_t pos, _T val) \
+{ \
+    _##_C##_node(pos.node)->elems[pos.i] = val; \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_front(_C##_t *list, _T val) \
+{ \
+    return _C##_insert(list, _C##_begin(list), val); \
+} \
+\
+_funcspecs _C##_pos_t _C##_insert_back(_C##_t *list, _T val) \
+{ \
+    return _C##_insert(list, _C##_end(list), val); \
+} \
+\
+_funcspecs void _C##_remove_front(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    _C##_remove(list, _C##_begin(list)); \
+} \
+\
+_funcspecs void _C##_remove_back(_C##_t *list) \
+{ \
+    assert(!_C##_empty(list)); \
+    _C##_remove(list, _C##_prev(_C##_end(list))); \
+} \
+\
+_funcspecs bool _C##_splice_front(_C##_t *dest_list, _C##_t *src_list, _C##_range_t range) \
+{ \
+    return _C##_splice(dest_list, _C##_begin(dest_list), src_list, range); \
+} \
+\
+_funcspecs bool _C##_splice_back(_C##_t *dest_list, _C##_t *src_list, _C##_range_t range) \
+{ \
+    return _C##_splice(dest_list, _C##_end(dest_list), src_list, range); \
+}
+
+#endif
@@ -19,6 +19,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "alloc.h"
+#include "growth.h"
+#include "stats.h"
+#include "traits.h"
+
 #define GCL_VECTOR_MINIMAL_CAPACITY     (16)
 #define GCL_VECTOR_INITIAL_CAPACITY     (16)
 #define GCL_VECTOR_GROWTH_FACTOR        (2)
@@ -50,29 +55,91 @@ struct _C { \
     _T *data_end; \
     _T *end; \
     void (*destroy_elem)(_T); \
+    const struct gcl_growth_policy *policy; \
 };
 
 #define GCL_GENERATE_VECTOR_FUNCTIONS_STATIC(_C, _T) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, static inline) \
     GCL_GENERATE_VECTOR_LONG_FUNCTION_DECLS(_C, _T, static) \
     GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
     GCL_GENERATE_VECTOR_LONG_FUNCTION_DEFS(_C, _T, static) \
     GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, static inline)
 
 #define GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H(_C, _T) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS(_C, _T, inline) \
     GCL_GENERATE_VECTOR_LONG_FUNCTION_DECLS(_C, _T, ) \
     GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, inline) \
     GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, inline)
 
 #define GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C, _T) \
+    _gcl_stats_define_extern(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, ) \
     GCL_GENERATE_VECTOR_LONG_FUNCTION_DEFS(_C, _T, ) \
     GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, )
 
+/*
+ * The _EX generators take a traits set (see traits.h) that replaces the
+ * destroy_elem member.
+ */
+#define GCL_GENERATE_VECTOR_FUNCTIONS_STATIC_EX(_C, _T, traits) \
+    _gcl_stats_define_static(_C, _T) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, static inline) \
+    GCL_GENERATE_VECTOR_LONG_FUNCTION_DECLS(_C, _T, static) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, static inline) \
+    GCL_GENERATE_VECTOR_LONG_FUNCTION_DEFS(_C, _T, static) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, static inline)
+
+#define GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_H_EX(_C, _T, traits) \
+    _gcl_stats_declare_extern(_C) \
+    GCL_GENERATE_ELEM_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_ELEM_FUNCTION_DEFS_EX(_C, _T, traits, inline) \
+    GCL_GENERATE_VECTOR_LONG_FUNCTION_DECLS(_C, _T, ) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DECLS(_C, _T, inline) \
+    GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, inline)
+
+#define GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C_EX(_C, _T, traits) \
+    GCL_GENERATE_VECTOR_FUNCTIONS_EXTERN_C(_C, _T)
+
 #define GCL_GENERATE_VECTOR_LONG_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_ALLOC_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DECLS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_BUFFER_FUNCTION_DECLS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_VECTOR_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_ALLOC_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DEFS(_C, _T, _funcspecs) \
+    GCL_GENERATE_VECTOR_BUFFER_FUNCTION_DEFS(_C, _T, _funcspecs)
+
+#define GCL_GENERATE_VECTOR_ALLOC_FUNCTION_DECLS(_C, _T, _funcspecs) \
 \
 _funcspecs _T *_##_C##_do_resize(struct _C *vec, size_t n); \
-_funcspecs _T *_##_C##_grow(struct _C *vec, size_t n); \
 _funcspecs _T *init_##_C(struct _C *vec, size_t n, void (*destroy_elem)(_T)); \
-_funcspecs void destroy_##_C(struct _C *vec); \
+_funcspecs void destroy_##_C(struct _C *vec);
+
+/*
+ * Buffer transfer: _C##_steal_buffer hands the storage of a vector to the
+ * caller and leaves the vector empty and without storage, and
+ * _C##_adopt_buffer replaces the contents of a vector with a block of
+ * capacity elements of which the first length are in use.  The block must
+ * have been allocated like container storage (see alloc.h), for instance by
+ * stealing it from another vector or ring buffer.  Since _C##_adopt_buffer
+ * destroys the current contents first, the vector must be initialized or
+ * have had its buffer stolen; it must not be an uninitialized struct.
+ */
+#define GCL_GENERATE_VECTOR_BUFFER_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *_C##_adopt_buffer(_C##_t *vec, _T *data, size_t length, size_t capacity); \
+_funcspecs _T *_C##_steal_buffer(_C##_t *vec, size_t *length, size_t *capacity); \
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2);
+
+#define GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DECLS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *_##_C##_grow(struct _C *vec, size_t n); \
 _funcspecs _C##_pos_t _C##_insert(_C##_t *vec, _C##_pos_t pos, _T val); \
 _funcspecs _C##_pos_t _C##_insert_back(_C##_t *vec, _T val); \
 _funcspecs _C##_pos_t _C##_release(_C##_t *vec, _C##_pos_t pos); \
@@ -90,6 +157,7 @@ _funcspecs size_t _C##_length(_C##_t *vec); \
 _funcspecs bool _C##_empty(_C##_t *vec); \
 _funcspecs size_t _C##_capacity(_C##_t *vec); \
 _funcspecs size_t _C##_max_capacity(void); \
+_funcspecs void _C##_set_policy(_C##_t *vec, const struct gcl_growth_policy *policy); \
 _funcspecs _T *_C##_reserve(_C##_t *vec, size_t n); \
 _funcspecs _T *_C##_shrink(_C##_t *vec); \
 _funcspecs _C##_pos_t _C##_begin(_C##_t *vec); \
@@ -118,9 +186,11 @@ _funcspecs _T *_C##_get_ptr(_C##_pos_t pos); \
 _funcspecs void _C##_set(_C##_pos_t pos, _T val); \
 _funcspecs _C##_pos_t _C##_insert_front(_C##_t *vec, _T val); \
 _funcspecs void _C##_remove_front(_C##_t *vec); \
-_funcspecs void _C##_remove_back(_C##_t *vec);
+_funcspecs void _C##_remove_back(_C##_t *vec); \
+_funcspecs _C##_pos_t _C##_remove_unordered(_C##_t *vec, _C##_pos_t pos); \
+_funcspecs void _C##_release_tail(_C##_t *vec, _C##_pos_t pos);
 
-#define GCL_GENERATE_VECTOR_LONG_FUNCTION_DEFS(_C, _T, _funcspecs) \
+#define GCL_GENERATE_VECTOR_ALLOC_FUNCTION_DEFS(_C, _T, _funcspecs) \
 \
 _funcspecs _T *_##_C##_do_resize(struct _C *vec, size_t n) \
 { \
@@ -135,38 +205,22 @@ _funcspecs _T *_##_C##_do_resize(struct _C *vec, size_t n) \
     if (n == _gcl_vector_capacity(vec)) \
         return vec->data; \
 \
-    if (!(data = realloc(vec->data, n * sizeof(_T)))) { \
+    if (!(data = _gcl_realloc(vec->data, _gcl_vector_capacity(vec) * sizeof(_T), \
+                              n * sizeof(_T)))) { \
         GCL_ERROR(errno, "Reallocating memory for vector failed"); \
         return NULL; \
     } \
 \
+    if (vec->policy && vec->policy->round_to_usable_size) \
+        n = _gcl_usable_size(data, n * sizeof(_T)) / sizeof(_T); \
+\
+    _gcl_stats_resize(_C, n, length); \
     vec->data = data; \
     vec->data_end = data + n; \
     vec->end = data + length; \
     return data; \
 } \
 \
-_funcspecs _T *_##_C##_grow(struct _C *vec, size_t n) \
-{ \
-    assert(n > _gcl_vector_length(vec)); \
-\
-    size_t max_cap = _C##_max_capacity(); \
-    size_t new_cap; \
-\
-    if (n > max_cap) \
-        return NULL; \
-\
-    new_cap = (size_t) (_gcl_vector_capacity(vec) * GCL_VECTOR_GROWTH_FACTOR); \
-\
-    if (new_cap > max_cap) \
-        new_cap = max_cap; \
-\
-    if (new_cap < n) \
-        new_cap = n; \
-\
-    return _##_C##_do_resize(vec, new_cap); \
-} \
-\
 _funcspecs _T *init_##_C(struct _C *vec, size_t n, void (*destroy_elem)(_T)) \
 { \
     _T *data; \
@@ -174,16 +228,19 @@ _funcspecs _T *init_##_C(struct _C *vec, size_t n, void (*destroy_elem)(_T)) \
     if (n < GCL_VECTOR_INITIAL_CAPACITY) \
         n = GCL_VECTOR_INITIAL_CAPACITY; \
 \
-    if (!(data = malloc(n * sizeof(_T)))) { \
+    if (!(data = _gcl_malloc(n * sizeof(_T)))) { \
         GCL_ERROR(errno, "Allocating memory for vector failed"); \
         return NULL; \
     } \
 \
+    _gcl_stats_alloc(_C); \
+    _gcl_stats_capacity(_C, n, 0); \
     *vec = (struct _C) { \
         .data = data, \
         .data_end = data + n, \
         .end = data, \
-        .destroy_elem = destroy_elem \
+        .destroy_elem = destroy_elem, \
+        .policy = NULL \
     }; \
     return data; \
 } \
@@ -192,12 +249,41 @@ _funcspecs void destroy_##_C(struct _C *vec) \
 { \
     _T *pos; \
 \
-    if (vec->destroy_elem) { \
+    if (!_##_C##_trivial_elem(vec)) { \
         _gcl_vector_for_each_pos(pos, vec) \
-            vec->destroy_elem(*pos); \
+            _##_C##_destroy_elem(vec, *pos); \
     } \
 \
-    free(vec->data); \
+    _gcl_stats_free(_C); \
+    _gcl_free(vec->data, _gcl_vector_capacity(vec) * sizeof(_T)); \
+}
+
+#define GCL_GENERATE_VECTOR_MODIFY_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *_##_C##_grow(struct _C *vec, size_t n) \
+{ \
+    assert(n > _gcl_vector_length(vec)); \
+\
+    size_t max_cap = _C##_max_capacity(); \
+    size_t new_cap; \
+\
+    _gcl_stats_grow(_C); \
+\
+    if (n > max_cap) \
+        return NULL; \
+\
+    if (vec->policy) \
+        new_cap = gcl_growth_policy_next(vec->policy, _gcl_vector_capacity(vec), n); \
+    else \
+        new_cap = (size_t) (_gcl_vector_capacity(vec) * GCL_VECTOR_GROWTH_FACTOR); \
+\
+    if (new_cap > max_cap) \
+        new_cap = max_cap; \
+\
+    if (new_cap < n) \
+        new_cap = n; \
+\
+    return _##_C##_do_resize(vec, new_cap); \
 } \
 \
 _funcspecs _C##_pos_t _C##_insert(_C##_t *vec, _C##_pos_t pos, _T val) \
@@ -220,6 +306,7 @@ _funcspecs _C##_pos_t _C##_insert(_C##_t *vec, _C##_pos_t pos, _T val) \
 \
     *pos = val; \
     vec->end++; \
+    _gcl_stats_length(_C, _gcl_vector_length(vec)); \
     return pos; \
 } \
 \
@@ -235,6 +322,7 @@ _funcspecs _C##_pos_t _C##_insert_back(_C##_t *vec, _T val) \
     assert(_gcl_vector_capacity(vec) > _gcl_vector_length(vec)); \
 \
     *vec->end++ = val; \
+    _gcl_stats_length(_C, _gcl_vector_length(vec)); \
     return vec->end - 1; \
 } \
 \
@@ -244,6 +332,7 @@ _funcspecs _C##_pos_t _C##_release(_C##_t *vec, _C##_pos_t pos) \
 \
     _##_C##_move_data(pos + 1, _gcl_vector_end(vec), pos); \
     vec->end--; \
+    _gcl_stats_capacity(_C, _gcl_vector_capacity(vec), _gcl_vector_length(vec)); \
     return pos; \
 } \
 \
@@ -251,22 +340,67 @@ _funcspecs _C##_pos_t _C##_remove(_C##_t *vec, _C##_pos_t pos) \
 { \
     assert(_##_C##_valid_pos(vec, pos) && pos != _gcl_vector_end(vec)); \
 \
-    if (vec->destroy_elem) \
-        vec->destroy_elem(*pos); \
+    _##_C##_destroy_elem(vec, *pos); \
+\
+    pos = _C##_release(vec, pos); \
+\
+    size_t n = gcl_growth_policy_shrink(vec->policy, _gcl_vector_length(vec), \
+                                        _gcl_vector_capacity(vec)); \
+\
+    if (n) { \
+        size_t i = (size_t) (pos - vec->data); \
+        if (_##_C##_do_resize(vec, n)) \
+            pos = vec->data + i; \
+    } \
 \
-    return _C##_release(vec, pos); \
+    return pos; \
 } \
 \
 _funcspecs void _C##_clear(_C##_t *vec) \
 { \
     _T *pos; \
 \
-    if (vec->destroy_elem) { \
+    if (!_##_C##_trivial_elem(vec)) { \
         _gcl_vector_for_each_pos(pos, vec) \
-            vec->destroy_elem(*pos); \
+            _##_C##_destroy_elem(vec, *pos); \
     } \
 \
     vec->end = vec->data; \
+    _gcl_stats_capacity(_C, _gcl_vector_capacity(vec), 0); \
+}
+
+#define GCL_GENERATE_VECTOR_BUFFER_FUNCTION_DEFS(_C, _T, _funcspecs) \
+\
+_funcspecs _T *_C##_adopt_buffer(_C##_t *vec, _T *data, size_t length, size_t capacity) \
+{ \
+    assert(length <= capacity); \
+\
+    destroy_##_C(vec); \
+    vec->data = data; \
+    vec->data_end = data + capacity; \
+    vec->end = data + length; \
+    _gcl_stats_length(_C, length); \
+    _gcl_stats_capacity(_C, capacity, length); \
+    return data; \
+} \
+\
+_funcspecs _T *_C##_steal_buffer(_C##_t *vec, size_t *length, size_t *capacity) \
+{ \
+    _T *data = vec->data; \
+\
+    *length = _gcl_vector_length(vec); \
+    *capacity = _gcl_vector_capacity(vec); \
+    vec->data = NULL; \
+    vec->data_end = NULL; \
+    vec->end = NULL; \
+    return data; \
+} \
+\
+_funcspecs void _C##_swap(_C##_t *vec1, _C##_t *vec2) \
+{ \
+    struct _C tmp = *vec1; \
+    *vec1 = *vec2; \
+    *vec2 = tmp; \
 }
 
 #define GCL_GENERATE_VECTOR_SHORT_FUNCTION_DEFS(_C, _T, _funcspecs) \
@@ -295,8 +429,10 @@ _funcspecs _C##_pos_t _##_C##_pos_of_index(struct _C *vec, size_t i) \
 \
 _funcspecs void _##_C##_move_data(_T *begin, _T *end, _T *dest) \
 { \
-    if (begin < end) \
+    if (begin < end) { \
+        _gcl_stats_moved(_C, (end - begin) * sizeof(_T)); \
         memmove(dest, begin, (end - begin) * sizeof(_T)); \
+    } \
 } \
 \
 _funcspecs size_t _C##_length(_C##_t *vec) \
@@ -319,6 +455,11 @@ _funcspecs size_t _C##_max_capacity(void) \
     return (size_t) (SIZE_MAX / (GCL_VECTOR_GROWTH_FACTOR * sizeof(_T))); \
 } \
 \
+_funcspecs void _C##_set_policy(_C##_t *vec, const struct gcl_growth_policy *policy) \
+{ \
+    vec->policy = policy; \
+} \
+\
 _funcspecs _T *_C##_reserve(_C##_t *vec, size_t n) \
 { \
     assert(n <= _C##_max_capacity()); \
@@ -419,7 +560,7 @@ _funcspecs _C##_range_t _C##_range_to_pos(_C##_t *vec, _C##_pos_t pos) \
 _funcspecs size_t _C##_range_length(_C##_range_t range) \
 { \
     assert(range.begin <= range.end); \
-    return (size_t) (range.begin - range.end); \
+    return (size_t) (range.end - range.begin); \
 } \
 \
 _funcspecs bool _C##_range_empty(_C##_range_t range) \
@@ -475,6 +616,24 @@ _funcspecs void _C##_remove_back(_C##_t *vec) \
 { \
     assert(!_C##_empty(vec)); \
     _C##_remove(vec, _gcl_vector_end(vec) - 1); \
+} \
+\
+_funcspecs _C##_pos_t _C##_remove_unordered(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    assert(_##_C##_valid_pos(vec, pos) && pos != _gcl_vector_end(vec)); \
+\
+    _##_C##_destroy_elem(vec, *pos); \
+\
+    *pos = *--vec->end; \
+    _gcl_stats_capacity(_C, _gcl_vector_capacity(vec), _gcl_vector_length(vec)); \
+    return pos; \
+} \
+\
+_funcspecs void _C##_release_tail(_C##_t *vec, _C##_pos_t pos) \
+{ \
+    assert(_##_C##_valid_pos(vec, pos)); \
+    vec->end = pos; \
+    _gcl_stats_capacity(_C, _gcl_vector_capacity(vec), _gcl_vector_length(vec)); \
 }
 
 #endif